@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake.h"
+
+/*
+ * Microbenchmarks of the game core and of the OLED command encoding.
+ *
+ * usage: snake_bench [-j] [-t min_ms]
+ *   -j  print one JSON document instead of a table
+ *   -t  minimum run time of each case (default 200 ms)
+ *
+ * Engine cases, for snake lengths up to SNAKE_WIN_LENGTH:
+ *   move_ring  - Snake_MoveArray(), a head push into the body ring
+ *   move_shift - the previous body layout, shifting every segment of an x/y array each tick
+ *   collision  - Snake_CollisionDetection() with the head on every cell in turn
+ *   food       - Snake_GenerateFood(), popcount-select over the occupancy words, O(words)
+ *   step       - Snake_Step() of one autopilot tick, including restoring the state
+ *   tick       - Snake_Move(): the step, drawing the cells it changed and encoding the changed columns
+ *   redraw     - Snake_Load(): drawing the whole board into a new frame, as a new round does
+ * Encoding cases, sent to the "null" OLED backend so no syscall is timed:
+ *   text       - OLED_SetCursor() and OLED_Display() of a menu line
+ *   batch_page - one OLED_Batch with a full-page BLIT record
+ *   frame_full - OLED_FrameEnd() of a frame that changed everywhere
+ *
+ * The engine and tick cases run on BENCH_TICKS consecutive ticks of an
+ * autopilot game, so the body has its real shape. The tick case plays them in
+ * a loop over the frame that shows the first one, as the game keeps its frame
+ * between ticks. Allocations are counted by linking with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see the bench target of the
+ * Makefile); without it they are reported as unknown. The ring column should
+ * stay flat as the length grows and no case should allocate.
+ */
+
+#ifndef BENCH_FLAGS
+#define BENCH_FLAGS     ""        // Optimisation flags of this build, set by the Makefile
+#endif
+
+static const int bench_lengths[] = { 2, 8, 32, 64, 128, SNAKE_WIN_LENGTH };
+#define BENCH_LENGTHS   (int)(sizeof(bench_lengths) / sizeof(bench_lengths[0]))
+
+#define BENCH_TICKS     64        // Consecutive autopilot ticks kept per length
+
+// Consecutive autopilot ticks per length, the input of each and the frame showing the first one
+static Snake_State bench_states[BENCH_LENGTHS][BENCH_TICKS];
+static int bench_inputs[BENCH_LENGTHS][BENCH_TICKS];
+static int bench_ticks[BENCH_LENGTHS];
+static OLED_Frame bench_frames[BENCH_LENGTHS];
+
+static int shift_xy[2][SNAKE_ARRAY_SIZE];  // Body for the shifting reference
+static OLED_Frame bench_frame;             // Frame for the encoding cases
+static int bench_fd;                       // fd of the null backend
+static volatile int bench_sink;            // Keeps the results alive
+static double bench_min_ns = 200e6;        // Minimum run time of a case
+static int bench_json;                     // Print JSON instead of a table
+static int bench_results;                  // Results printed so far
+
+/*
+ * Allocation counting. With --wrap, calls of malloc() from every object of
+ * the benchmark (the game code included) land here first.
+ */
+static volatile unsigned long bench_allocs;  // volatile: the compiler assumes malloc() leaves globals alone
+
+// Weak, so the benchmark still links without --wrap (the wrappers are then never called)
+extern void *__real_malloc(size_t size) __attribute__((weak));
+extern void *__real_calloc(size_t n, size_t size) __attribute__((weak));
+extern void *__real_realloc(void *ptr, size_t size) __attribute__((weak));
+
+void *__wrap_malloc(size_t size) {
+    bench_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    bench_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    bench_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+// Check that the wrappers are linked in, so a count of 0 means no allocation
+static int Bench_CountsAllocs(void) {
+    unsigned long before = bench_allocs;
+    void *volatile p = malloc(16);
+
+    free(p);
+    return bench_allocs != before;
+}
+
+// Nanoseconds on CLOCK_MONOTONIC
+static double Bench_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Circle around a 2x2 square so the snake never runs off to huge coordinates
+static int Bench_Direction(long tick) {
+    static const int dirs[4] = { SNAKE_RIGHT, SNAKE_DOWN, SNAKE_LEFT, SNAKE_UP };
+    return dirs[tick & 3];
+}
+
+/*
+ * Cases: each runs its operation n times for the length at index l.
+ */
+typedef void (*Bench_Case)(long n, int l);
+
+static void Bench_MoveRing(long n, int l) {
+    static Snake_State state;
+    long t;
+
+    Snake_Init(&state, 1, 1);
+    state.length = bench_lengths[l];
+    Snake_PrepareArray(&state);
+
+    for (t = 0; t < n; t++) {
+        Snake_MoveArray(&state, Bench_Direction(t));
+    }
+    bench_sink = Snake_SegmentX(&state, state.length - 1);
+}
+
+// The body move as it was before the ring: O(length) per tick
+static void Bench_MoveShift(long n, int l) {
+    int length = bench_lengths[l];
+    long t;
+    int i, direction;
+
+    memset(shift_xy, 0, sizeof(shift_xy));
+
+    for (t = 0; t < n; t++) {
+        direction = Bench_Direction(t);
+        for (i = length - 1; i >= 1; i--) {
+            shift_xy[0][i] = shift_xy[0][i - 1];
+            shift_xy[1][i] = shift_xy[1][i - 1];
+        }
+        shift_xy[0][0] += (direction == SNAKE_RIGHT) - (direction == SNAKE_LEFT);
+        shift_xy[1][0] += (direction == SNAKE_DOWN) - (direction == SNAKE_UP);
+    }
+    bench_sink = shift_xy[0][length - 1];
+}
+
+static void Bench_Collision(long n, int l) {
+    static Snake_State state;
+    int hits = 0;
+    long t;
+
+    Snake_Snapshot(&bench_states[l][0], &state);
+    for (t = 0; t < n; t++) {
+        state.body[state.head] = t % SNAKE_CELLS;
+        hits += Snake_CollisionDetection(&state);
+    }
+    bench_sink = hits;
+}
+
+static void Bench_Food(long n, int l) {
+    static Snake_State state;
+    int sum = 0;
+    long t;
+
+    Snake_Snapshot(&bench_states[l][0], &state);
+    for (t = 0; t < n; t++) {
+        Snake_GenerateFood(&state);
+        sum += state.food;
+    }
+    bench_sink = sum;
+}
+
+static void Bench_Step(long n, int l) {
+    static Snake_State state;
+    int events = 0, i = 0;
+    long t;
+
+    for (t = 0; t < n; t++) {
+        Snake_Restore(&state, &bench_states[l][i]);
+        events |= Snake_Step(&state, bench_inputs[l][i]);
+        i = i + 1 < bench_ticks[l] ? i + 1 : 0;
+    }
+    bench_sink = events;
+}
+
+// Play the recorded ticks in a loop; going back to the first one costs a state and a frame copy
+static void Bench_Tick(long n, int l) {
+    static Snake_State state;
+    int events = 0, i = 0;
+    long t;
+
+    for (t = 0; t < n; t++) {
+        if (!i) {
+            Snake_Restore(&state, &bench_states[l][0]);
+            bench_frame = bench_frames[l];
+        }
+        events |= Snake_Move(&bench_frame, &state, bench_inputs[l][i]);
+        i = i + 1 < bench_ticks[l] ? i + 1 : 0;
+    }
+    bench_sink = events;
+}
+
+static void Bench_Redraw(long n, int l) {
+    long t;
+
+    for (t = 0; t < n; t++) {
+        Snake_Load(&bench_frame, &bench_states[l][t % bench_ticks[l]]);
+    }
+}
+
+static void Bench_Text(long n, int l) {
+    char text[] = "PRESS TO CONTINUE";
+    long t;
+
+    for (t = 0; t < n; t++) {
+        OLED_SetCursor(bench_fd, 10, 4);
+        OLED_Display(bench_fd, text);
+    }
+}
+
+static void Bench_BatchPage(long n, int l) {
+    static OLED_Batch batch;
+    unsigned char column[OLED_WIDTH];
+    long t;
+
+    memset(column, 0xAA, sizeof(column));
+    for (t = 0; t < n; t++) {
+        OLED_BatchBegin(&batch, bench_fd);
+        OLED_BatchBlit(&batch, 0, t & (OLED_PAGES - 1), column, OLED_WIDTH);
+        OLED_BatchFlush(&batch);
+    }
+}
+
+// Alternate a lit and a blank screen: eight full-page BLITs, then eight page clears
+static void Bench_FrameFull(long n, int l) {
+    long t;
+
+    for (t = 0; t < n; t++) {
+        OLED_FrameBegin(&bench_frame);
+        if (t & 1) {
+            OLED_FrameFill(&bench_frame, 0, 0, OLED_WIDTH, OLED_PAGES * 8, 1);
+        }
+        OLED_FrameEnd(&bench_frame);
+    }
+}
+
+// Play one autopilot game and keep up to BENCH_TICKS consecutive running ticks from every length on
+static void Bench_PrepareStates(void) {
+    static Snake_Autopilot autopilot;
+    Snake_State state;
+    int l = 0, n, input;
+
+    Snake_Init(&state, 1, 1);
+    Snake_AutopilotInit(&autopilot);
+
+    input = Snake_AutopilotPlan(&autopilot, &state);
+    while (state.status == SNAKE_RUNNING && l < BENCH_LENGTHS) {
+        // The longest length starts one segment short of the win
+        if (bench_ticks[l] || state.length >= bench_lengths[l] || state.length >= SNAKE_WIN_LENGTH - 1) {
+            n = bench_ticks[l]++;
+            bench_states[l][n] = state;
+            bench_inputs[l][n] = input;
+        }
+
+        Snake_Step(&state, input);
+        if (state.status == SNAKE_RUNNING) {
+            input = Snake_AutopilotPlan(&autopilot, &state);  // Once per running tick, like the game
+        }
+        if (bench_ticks[l] == BENCH_TICKS || (bench_ticks[l] && state.status != SNAKE_RUNNING)) {
+            l++;
+        }
+    }
+    for (; l < BENCH_LENGTHS; l++) {
+        if (!bench_ticks[l]) {
+            memcpy(bench_states[l], bench_states[l - 1], sizeof(bench_states[l]));
+            memcpy(bench_inputs[l], bench_inputs[l - 1], sizeof(bench_inputs[l]));
+            bench_ticks[l] = bench_ticks[l - 1];
+        }
+    }
+
+    // The frame each tick case starts from; Snake_Load() also builds the sprites
+    for (l = 0; l < BENCH_LENGTHS; l++) {
+        OLED_FrameInit(&bench_frames[l], bench_fd);
+        Snake_Load(&bench_frames[l], &bench_states[l][0]);
+    }
+}
+
+// Run a case with doubling repeat counts until it takes bench_min_ns, then print ns/op and allocations/op
+static void Bench_Run(const char *name, Bench_Case run, int l, int length, int counts_allocs) {
+    unsigned long allocs;
+    double start, ns;
+    long n = 1;
+    char len[12] = "-", per_op[16] = "?";
+
+    run(1, l);  // Warm up caches and the lazily initialised state
+    for (;;) {
+        allocs = bench_allocs;
+        start = Bench_Now();
+        run(n, l);
+        ns = Bench_Now() - start;
+        allocs = bench_allocs - allocs;
+        if (ns >= bench_min_ns || n > (1L << 40)) {
+            break;
+        }
+        n = ns > bench_min_ns / 100 ? (long)(n * bench_min_ns * 1.2 / ns) : n * 10;
+    }
+
+    if (bench_json) {
+        printf("%s\n    {\"case\": \"%s\", \"length\": ", bench_results ? "," : "", name);
+        if (length) {
+            printf("%d", length);
+        } else {
+            printf("null");
+        }
+        printf(", \"ops\": %ld, \"ns_per_op\": %.3f, \"allocs_per_op\": ", n, ns / n);
+        if (counts_allocs) {
+            printf("%.3f}", (double)allocs / n);
+        } else {
+            printf("null}");
+        }
+    } else {
+        if (length) {
+            snprintf(len, sizeof(len), "%d", length);
+        }
+        if (counts_allocs) {
+            snprintf(per_op, sizeof(per_op), "%.3f", (double)allocs / n);
+        }
+        printf("%-12s %8s %12.2f %12s\n", name, len, ns / n, per_op);
+    }
+    bench_results++;
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct {
+        const char *name;
+        Bench_Case run;
+        int state;  // Runs on the autopilot states, so reports their length
+    } cases[] = {
+        { "move_ring",  Bench_MoveRing,  0 },
+        { "move_shift", Bench_MoveShift, 0 },
+        { "collision",  Bench_Collision, 1 },
+        { "food",       Bench_Food,      1 },
+        { "step",       Bench_Step,      1 },
+        { "tick",       Bench_Tick,      1 },
+        { "redraw",     Bench_Redraw,    1 },
+    };
+    int opt, counts_allocs;
+    size_t c;
+    int l;
+
+    while ((opt = getopt(argc, argv, "jt:")) != -1) {
+        switch (opt) {
+        case 'j':
+            bench_json = 1;
+            break;
+        case 't':
+            bench_min_ns = atof(optarg) * 1e6;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-j] [-t min_ms]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    counts_allocs = Bench_CountsAllocs();
+    OLED_SetBackend("null");
+    bench_fd = OLED_GetBackend()->open();
+    OLED_FrameInit(&bench_frame, bench_fd);
+    Bench_PrepareStates();
+
+    if (bench_json) {
+        printf("{\n  \"compiler\": \"%s\",\n  \"flags\": \"%s\",\n  \"board\": \"%dx%d\",\n  \"cell\": \"%dx%d\",\n"
+               "  \"alloc_counting\": %s,\n  \"results\": [",
+               __VERSION__, BENCH_FLAGS, SNAKE_BOARD_W, SNAKE_BOARD_H, SNAKE_CELL_PX, SNAKE_CELL_PY,
+               counts_allocs ? "true" : "false");
+    } else {
+        printf("compiler %s, flags %s, board %dx%d%s\n", __VERSION__, BENCH_FLAGS, SNAKE_BOARD_W, SNAKE_BOARD_H,
+               counts_allocs ? "" : ", allocations not counted (link with --wrap=malloc)");
+        printf("%-12s %8s %12s %12s\n", "case", "length", "ns/op", "allocs/op");
+    }
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (l = 0; l < BENCH_LENGTHS; l++) {
+            Bench_Run(cases[c].name, cases[c].run, l,
+                      cases[c].state ? bench_states[l][0].length : bench_lengths[l], counts_allocs);
+        }
+    }
+    Bench_Run("text", Bench_Text, 0, 0, counts_allocs);
+    Bench_Run("batch_page", Bench_BatchPage, 0, 0, counts_allocs);
+    OLED_FrameInvalidate(&bench_frame);
+    Bench_Run("frame_full", Bench_FrameFull, 0, 0, counts_allocs);
+
+    if (bench_json) {
+        printf("\n  ]\n}\n");
+    }
+    close(bench_fd);
+    return 0;
+}
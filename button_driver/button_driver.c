@@ -10,10 +10,25 @@
 #include <linux/slab.h>             /* For memory allocation (cdev_init/cdev_add)  */
 #include <linux/uaccess.h>          /* For copy_to_user/copy_from_user functions */
 #include <linux/poll.h>             /* For poll operations */
+#include <linux/kfifo.h>            /* For the button event queue */
+#include <linux/ktime.h>            /* For event timestamps */
+#include <linux/mutex.h>            /* For serialising readers */
+#include <linux/debugfs.h>          /* For the statistics files */
+#include <linux/seq_file.h>         /* For printing the statistics */
+#include <linux/version.h>          /* For the kernel API differences between versions */
 
-/* Declarations of probe and remove functions */
+#include "../inc/button_event.h"    /* Event record shared with user space */
+
+#define CREATE_TRACE_POINTS
+#include "button_trace.h"           /* Tracepoints, under /sys/kernel/tracing/events/gpio_btn/ */
+
+/* Declarations of probe and remove functions; remove returns void since 6.11 */
 static int gpio_btn_probe(struct platform_device *pdev);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0)
+static void gpio_btn_remove(struct platform_device *pdev);
+#else
 static int gpio_btn_remove(struct platform_device *pdev);
+#endif
 
 /* Declarations of init and exit functions for the module */
 static int __init gpio_btn_init(void);
@@ -25,16 +40,33 @@ static int btn_release(struct inode *inode, struct file *file);
 static ssize_t btn_read(struct file *filp, char __user *user_buf, size_t size, loff_t *offset);
 static unsigned int btn_poll(struct file *file, poll_table *wait);
 
+/* Number of queued button events (power of two) */
+#define BTN_FIFO_SIZE   64
+
+/* Maximum number of events handed out by one read() */
+#define BTN_READ_BATCH  16
+
+/* IRQ-to-read() latency histogram: bucket n counts latencies in [2^(n-1), 2^n) us */
+#define BTN_LAT_BUCKETS 24
+
 /* Device structure to hold device-specific data */
 typedef struct {
     dev_t dev_num;                  // Device number (major/minor)
     struct class *btn_class;        // Device class
     struct cdev btn_cdev;           // Character device structure
-    bool is_event_ready;            // Flag to indicate if an event (button press) is ready
+    DECLARE_KFIFO(events, struct btn_event, BTN_FIFO_SIZE);  // Events not yet read
+    spinlock_t producer_lock;       // Serialises IRQ handlers pushing into events
+    struct mutex consumer_lock;     // Serialises readers popping from events
+    atomic_t dropped;               // Events lost because the queue was full
+    atomic_t queued;                // Events pushed into the queue
+    unsigned long delivered;        // Events handed to user space (updated under consumer_lock)
+    unsigned long reads;            // read() calls that returned events (updated under consumer_lock)
     wait_queue_head_t event_queue;  // Wait queue for read operations
+    u64 lat_hist[BTN_LAT_BUCKETS];  // IRQ-to-read() latency histogram (updated under consumer_lock)
+    u64 lat_max_us;                 // Worst IRQ-to-read() latency seen
+    struct dentry *debug_dir;       // /sys/kernel/debug/gpio_button
 } gpio_btn_dev;
 
-char btn_state[1];  // Buffer to store button state
 gpio_btn_dev btn_dev; // The button device structure
 
 /* Driver metadata */
@@ -45,23 +77,30 @@ gpio_btn_dev btn_dev; // The button device structure
 #define BUTTON_PRESSED    1
 #define BUTTON_RELEASED   0
 
-/* GPIO descriptors for each button */
-struct gpio_desc *gpio2_4;
-struct gpio_desc *gpio2_5;
-struct gpio_desc *gpio1_13;
-struct gpio_desc *gpio1_12;
-struct gpio_desc *gpio0_23;
+/* Per-button data, passed to the shared IRQ handler as dev_id */
+struct gpio_btn {
+    const char *con_id;             // Name of the "<con_id>-gpios" property in the device tree
+    u8 id;                          // Button number reported to user space
+    struct gpio_desc *gpiod;        // GPIO descriptor
+    int irq;                        // IRQ number of the GPIO
+    unsigned long presses;          // Press edges seen by the IRQ handler
+    unsigned long releases;         // Release edges seen by the IRQ handler
+    bool cansleep;                  // The GPIO chip sleeps, so the level is read in the IRQ thread
+    u64 edge_ns;                    // Time of the edge the IRQ thread is handling
+};
 
-/* IRQ numbers for each button */
-int irq_btn1, irq_btn2, irq_btn3, irq_btn4, irq_btn5;
-int check_status; // Variable to store the status of various operations
+/* Button table, in the order of the ids user space expects (UP, LEFT, RIGHT, DOWN, ENTER) */
+static struct gpio_btn gpio_btns[] = {
+    { .con_id = "button23", .id = 1 },  // gpio0_23
+    { .con_id = "button44", .id = 2 },  // gpio1_12
+    { .con_id = "button45", .id = 3 },  // gpio1_13
+    { .con_id = "button68", .id = 4 },  // gpio2_4
+    { .con_id = "button69", .id = 5 },  // gpio2_5
+};
 
-/* Declarations of IRQ handlers for each button */
-static irqreturn_t btn1_irq_handler(int irq, void *dev_id);
-static irqreturn_t btn2_irq_handler(int irq, void *dev_id);
-static irqreturn_t btn3_irq_handler(int irq, void *dev_id);
-static irqreturn_t btn4_irq_handler(int irq, void *dev_id);
-static irqreturn_t btn5_irq_handler(int irq, void *dev_id);
+/* Hard IRQ handler shared by all buttons, and the thread for GPIOs behind sleeping chips */
+static irqreturn_t btn_irq_handler(int irq, void *dev_id);
+static irqreturn_t btn_irq_thread(int irq, void *dev_id);
 
 /* Device tree match table */
 static const struct of_device_id gpio_btn_dt_ids[] = {
@@ -94,214 +133,209 @@ static struct file_operations btn_fops =
 /* Probe function: called when platform driver is registered */
 static int gpio_btn_probe(struct platform_device *pdev)
 {
-    pr_info("GPIO Button Driver: Probe function started\n");
     struct device *dev = &pdev->dev;
+    struct gpio_btn *btn;
+    int i, ret;
 
-    // Retrieve GPIOs from device tree
-    gpio0_23 =  gpiod_get(dev, "button23", GPIOD_IN); 
-    gpio1_13 =  gpiod_get(dev, "button45", GPIOD_IN); 
-    gpio1_12 =  gpiod_get(dev, "button44", GPIOD_IN);  
-    gpio2_4  =  gpiod_get(dev, "button68", GPIOD_IN); 
-    gpio2_5  =  gpiod_get(dev, "button69", GPIOD_IN);
-
-    // Set debounce time to avoid multiple triggers    
-    gpiod_set_debounce(gpio0_23, 200);
-    gpiod_set_debounce(gpio1_12, 200);
-    gpiod_set_debounce(gpio1_13, 200);
-    gpiod_set_debounce(gpio2_4,  200);
-    gpiod_set_debounce(gpio2_5,  200);
-
-    // Map GPIOs to IRQs
-    irq_btn1 = gpiod_to_irq(gpio0_23);
-    irq_btn2 = gpiod_to_irq(gpio1_12);
-    irq_btn3 = gpiod_to_irq(gpio1_13);
-    irq_btn4 = gpiod_to_irq(gpio2_4);
-    irq_btn5 = gpiod_to_irq(gpio2_5);
-
-    // Request IRQs and assign handlers
-    check_status = request_irq(irq_btn1, btn1_irq_handler, IRQF_TRIGGER_FALLING, "btn_irq1", NULL);
-    if (check_status)
-    {
-        pr_err("GPIO Button Driver: Failed to request IRQ1\n");
-        gpiod_put(gpio0_23); 
-        return check_status;
-    }
-
-    check_status = request_irq(irq_btn2, btn2_irq_handler, IRQF_TRIGGER_FALLING, "btn_irq2", NULL);
-    if (check_status)
-    {
-        pr_err("GPIO Button Driver: Failed to request IRQ2\n");
-        gpiod_put(gpio1_12);   
-        return check_status;
-    }
-
-    check_status = request_irq(irq_btn3, btn3_irq_handler, IRQF_TRIGGER_FALLING, "btn_irq3", NULL);
-    if (check_status)
-    {
-        pr_err("GPIO Button Driver: Failed to request IRQ3\n");
-        gpiod_put(gpio1_13);  
-        return check_status;
-    }
-
-    check_status = request_irq(irq_btn4, btn4_irq_handler, IRQF_TRIGGER_FALLING, "btn_irq4", NULL);
-    if (check_status)
-    {
-        pr_err("GPIO Button Driver: Failed to request IRQ4\n");
-        gpiod_put(gpio2_4);
-        return check_status;
-    }
+    pr_info("GPIO Button Driver: Probe function started\n");
 
-    check_status = request_irq(irq_btn5, btn5_irq_handler, IRQF_TRIGGER_FALLING, "btn_irq5", NULL);
-    if (check_status)
-    {
-        pr_err("GPIO Button Driver: Failed to request IRQ5n");
-        gpiod_put(gpio2_5);
-        return check_status;
+    for (i = 0; i < ARRAY_SIZE(gpio_btns); i++) {
+        btn = &gpio_btns[i];
+
+        // Retrieve the GPIO from device tree
+        btn->gpiod = devm_gpiod_get(dev, btn->con_id, GPIOD_IN);
+        if (IS_ERR(btn->gpiod)) {
+            pr_err("GPIO Button Driver: Failed to get %s GPIO\n", btn->con_id);
+            return PTR_ERR(btn->gpiod);
+        }
+
+        // Set debounce time to avoid multiple triggers
+        gpiod_set_debounce(btn->gpiod, 200);
+
+        // Map the GPIO to its IRQ
+        btn->irq = gpiod_to_irq(btn->gpiod);
+        if (btn->irq < 0) {
+            pr_err("GPIO Button Driver: No IRQ for %s\n", btn->con_id);
+            return btn->irq;
+        }
+
+        // Chips behind a slow bus (or gpio-sim) can only be read from the IRQ thread;
+        // the line stays masked until it ran, so edge_ns is not overwritten meanwhile
+        btn->cansleep = gpiod_cansleep(btn->gpiod);
+        ret = devm_request_threaded_irq(dev, btn->irq, btn_irq_handler,
+                                        btn->cansleep ? btn_irq_thread : NULL,
+                                        IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING |
+                                        (btn->cansleep ? IRQF_ONESHOT : 0),
+                                        btn->con_id, btn);
+        if (ret) {
+            pr_err("GPIO Button Driver: Failed to request IRQ for %s\n", btn->con_id);
+            return ret;
+        }
     }
 
     pr_info("GPIO Button Driver: Probe function completed successfully\n");
     return 0;
 }
 
-/* Remove function: called when platform driver is removed */
+/* Remove function: called when platform driver is removed; IRQs and GPIOs are device-managed */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0)
+static void gpio_btn_remove(struct platform_device *pdev)
+#else
 static int gpio_btn_remove(struct platform_device *pdev)
+#endif
 {
-    pr_info("GPIO Button Driver: Removing device and freeing resources\n");
-
-    // Free IRQs and associated GPIOs
-    free_irq(irq_btn1, NULL);
-    gpiod_put(gpio0_23);
-
-    free_irq(irq_btn2, NULL);
-    gpiod_put(gpio1_12);
-
-    free_irq(irq_btn3, NULL);
-    gpiod_put(gpio1_13);
-
-    free_irq(irq_btn4, NULL);
-    gpiod_put(gpio2_4);
-
-    free_irq(irq_btn5, NULL);
-    gpiod_put(gpio2_5);
-
     pr_info("GPIO Button Driver: Resources freed successfully\n");
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 11, 0)
     return 0;
+#endif
 }
 
-/* IRQ handler for Button 1 */
-static irqreturn_t btn1_irq_handler(int irq, void *dev_id) {
-    bool pressed = gpiod_get_value(gpio0_23); // Get the current state of the GPIO
-    
-    if (pressed) {
-        pr_info("GPIO Button Driver: Button 1 Pressed\n");
-    } else {
-        pr_info("GPIO Button Driver: Button 1 Released\n");
-    }
-    
-    btn_state[0] = '1';  // Store the button event in the buffer
-    btn_dev.is_event_ready = true; // Set the event ready flag
-    wake_up_interruptible(&btn_dev.event_queue);  // Wake up any readers waiting for an event
-    return IRQ_HANDLED;
-}
+/* Counts the edge of a button and queues its event for readers; called from the IRQ handlers */
+static void btn_push_event(struct gpio_btn *btn, bool pressed, u64 ts_ns)
+{
+    struct btn_event ev = {
+        .id = btn->id,
+        .pressed = pressed,
+        .ts_ns = ts_ns,
+    };
+
+    bool queued;
 
-/* IRQ handler for Button 2 */
-static irqreturn_t btn2_irq_handler(int irq, void *dev_id) {
-    bool pressed = gpiod_get_value(gpio1_12);
-    
     if (pressed) {
-        pr_info("GPIO Button Driver: Button 2 Pressed\n");
+        btn->presses++;
     } else {
-        pr_info("GPIO Button Driver: Button 2 Released\n");
+        btn->releases++;
     }
 
-    btn_state[0] = '2';
-    btn_dev.is_event_ready = true;
-    wake_up_interruptible(&btn_dev.event_queue);
-    return IRQ_HANDLED;
-}
-
-/* IRQ handler for Button 3 */
-static irqreturn_t btn3_irq_handler(int irq, void *dev_id) {
-    bool pressed = gpiod_get_value(gpio1_13);
-    
-    if (pressed) {
-        pr_info("GPIO Button Driver: Button 3 Pressed\n");
+    /* Lock-free against the reader; the spinlock only orders the five producers */
+    queued = kfifo_in_spinlocked(&btn_dev.events, &ev, 1, &btn_dev.producer_lock);
+    if (queued) {
+        atomic_inc(&btn_dev.queued);
     } else {
-        pr_info("GPIO Button Driver: Button 3 Released\n");
+        atomic_inc(&btn_dev.dropped);  // Queue full, the oldest events are kept
     }
-    
-    btn_state[0] = '3';
-    btn_dev.is_event_ready = true;
-    wake_up_interruptible(&btn_dev.event_queue);
-    return IRQ_HANDLED;
+    trace_gpio_btn_irq(btn->id, pressed, queued);
+    wake_up_interruptible(&btn_dev.event_queue);  // Wake up any readers waiting for an event
 }
 
-/* IRQ handler for Button 4 */
-static irqreturn_t btn4_irq_handler(int irq, void *dev_id) {
-    bool pressed = gpiod_get_value(gpio2_4);
-    
-    if (pressed) {
-        pr_info("GPIO Button Driver: Button 4 Pressed\n");
-    } else {
-        pr_info("GPIO Button Driver: Button 4 Released\n");
+/* Hard IRQ handler shared by all buttons: timestamps and queues the edge, nothing slow */
+static irqreturn_t btn_irq_handler(int irq, void *dev_id)
+{
+    struct gpio_btn *btn = dev_id;
+    u64 now = ktime_get_ns();
+
+    // A sleeping chip cannot be read here; keep the edge time for the thread
+    if (btn->cansleep) {
+        btn->edge_ns = now;
+        return IRQ_WAKE_THREAD;
     }
 
-    btn_state[0] = '4';
-    btn_dev.is_event_ready = true;
-    wake_up_interruptible(&btn_dev.event_queue);
+    btn_push_event(btn, gpiod_get_value(btn->gpiod), now);
     return IRQ_HANDLED;
 }
 
-/* IRQ handler for Button 5 */
-static irqreturn_t btn5_irq_handler(int irq, void *dev_id) {
-    bool pressed = gpiod_get_value(gpio2_5);
-    
-    if (pressed) {
-        pr_info("GPIO Button Driver: Button 5 Pressed\n");
-    } else {
-        pr_info("GPIO Button Driver: Button 5 Released\n");
-    }
+/* IRQ thread for buttons on sleeping GPIO chips: reads the level, timestamped at the edge */
+static irqreturn_t btn_irq_thread(int irq, void *dev_id)
+{
+    struct gpio_btn *btn = dev_id;
 
-    btn_state[0] = '5';
-    btn_dev.is_event_ready = true;
-    wake_up_interruptible(&btn_dev.event_queue);
+    btn_push_event(btn, gpiod_get_value_cansleep(btn->gpiod), btn->edge_ns);
     return IRQ_HANDLED;
 }
 
 /* Open function for the device file */
 static int btn_open(struct inode *inode, struct file *file) 
 {
-    pr_info("Button Driver: Device file opened\n");
+    pr_debug("Button Driver: Device file opened\n");
     return 0;
 }
 
 /* Release function for the device file */
 static int btn_release(struct inode *inode, struct file *file) {
-    pr_info("Button Driver: Device file closed\n");
+    pr_debug("Button Driver: Device file closed\n");
     return 0;
 }
 
-/* Read function for the device file */
-static ssize_t btn_read(struct file *filp, char __user *user_buf, size_t size, loff_t *offset) {
-    ssize_t result = 0;
+/* Records the IRQ-to-read() latency of an event being handed out (consumer_lock held) */
+static void btn_account_latency(const struct btn_event *ev, u64 now_ns)
+{
+    u64 us = div_u64(now_ns - ev->ts_ns, NSEC_PER_USEC);
+    int bucket = min(fls64(us), BTN_LAT_BUCKETS - 1);
+
+    trace_gpio_btn_read(ev->id, ev->pressed, now_ns - ev->ts_ns);
+    btn_dev.delivered++;
+    btn_dev.lat_hist[bucket]++;
+    if (us > btn_dev.lat_max_us)
+        btn_dev.lat_max_us = us;
+}
 
-    // Wait until an event is available (button press)
-    wait_event_interruptible(btn_dev.event_queue, btn_dev.is_event_ready);
+/* Legacy read: returns the next press as one ASCII digit, skipping releases */
+static ssize_t btn_read_legacy(struct file *filp, char __user *user_buf)
+{
+    struct btn_event ev;
+    char key;
+
+    for (;;) {
+        mutex_lock(&btn_dev.consumer_lock);
+        while (kfifo_get(&btn_dev.events, &ev)) {
+            if (ev.pressed) {
+                btn_account_latency(&ev, ktime_get_ns());
+                btn_dev.reads++;
+                mutex_unlock(&btn_dev.consumer_lock);
+                key = '0' + ev.id;
+                if (copy_to_user(user_buf, &key, 1)) {
+                    pr_err("GPIO Button Driver: Failed to copy data to user space\n");
+                    return -EFAULT;
+                }
+                return 1;
+            }
+        }
+        mutex_unlock(&btn_dev.consumer_lock);
+
+        if (filp->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        if (wait_event_interruptible(btn_dev.event_queue, !kfifo_is_empty(&btn_dev.events)))
+            return -ERESTARTSYS;
+    }
+}
 
-    // If no event is ready, return 0
-    if (!btn_dev.is_event_ready)
-        return 0;
+/* Read function for the device file: drains as many queued events as fit in the buffer */
+static ssize_t btn_read(struct file *filp, char __user *user_buf, size_t size, loff_t *offset) {
+    struct btn_event evs[BTN_READ_BATCH];
+    unsigned int n, i;
+    u64 now;
+
+    if (size < sizeof(struct btn_event))
+        return btn_read_legacy(filp, user_buf);
+
+    // Take whole event records from the queue under the lock, so another reader
+    // cannot empty it between the check and the copy; wait while there are none
+    for (;;) {
+        mutex_lock(&btn_dev.consumer_lock);
+        n = kfifo_out(&btn_dev.events, evs, min_t(size_t, size / sizeof(evs[0]), BTN_READ_BATCH));
+        if (n)
+            break;
+        mutex_unlock(&btn_dev.consumer_lock);
+
+        if (filp->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        if (wait_event_interruptible(btn_dev.event_queue, !kfifo_is_empty(&btn_dev.events)))
+            return -ERESTARTSYS;
+    }
+
+    // Account their delivery latency
+    now = ktime_get_ns();
+    for (i = 0; i < n; i++)
+        btn_account_latency(&evs[i], now);
+    btn_dev.reads++;
+    mutex_unlock(&btn_dev.consumer_lock);
 
-    // Copy the button state from kernel to user space
-    if (copy_to_user(user_buf, btn_state, 1)) {
+    // Copy the events from kernel to user space
+    if (copy_to_user(user_buf, evs, n * sizeof(evs[0]))) {
         pr_err("GPIO Button Driver: Failed to copy data to user space\n");
-        result = -EFAULT; 
-    } else {
-        btn_dev.is_event_ready = false;  // Reset the event flag
-        result = 1;  // Return the number of bytes read
+        return -EFAULT;
     }
-
-    return result;
+    return n * sizeof(evs[0]);  // Return the number of bytes read
 }
 
 /* Poll function for the device file */
@@ -309,11 +343,86 @@ static unsigned int btn_poll(struct file *file, poll_table *wait) {
     unsigned int reval_mask = 0;
     poll_wait(file, &btn_dev.event_queue, wait); // Add the wait queue to the poll table
 
-    if (btn_dev.is_event_ready)
+    if (!kfifo_is_empty(&btn_dev.events))
         reval_mask |= POLLIN | POLLRDNORM;  // Data is available to read
     return reval_mask;
 }
 
+/* Number of events lost to a full queue, in /sys/class/gpio_btn_class/my_button_snake/dropped */
+static ssize_t dropped_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%d\n", atomic_read(&btn_dev.dropped));
+}
+static DEVICE_ATTR_RO(dropped);
+
+/* Number of events pushed into the queue, in .../my_button_snake/queued */
+static ssize_t queued_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%d\n", atomic_read(&btn_dev.queued));
+}
+static DEVICE_ATTR_RO(queued);
+
+/* Number of events handed to user space, in .../my_button_snake/delivered */
+static ssize_t delivered_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%lu\n", READ_ONCE(btn_dev.delivered));
+}
+static DEVICE_ATTR_RO(delivered);
+
+/* Number of read() calls that returned events, in .../my_button_snake/reads */
+static ssize_t reads_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%lu\n", READ_ONCE(btn_dev.reads));
+}
+static DEVICE_ATTR_RO(reads);
+
+static struct attribute *btn_attrs[] = {
+    &dev_attr_dropped.attr,
+    &dev_attr_queued.attr,
+    &dev_attr_delivered.attr,
+    &dev_attr_reads.attr,
+    NULL,
+};
+ATTRIBUTE_GROUPS(btn);
+
+/* Per-button counters, in /sys/kernel/debug/gpio_button/stats */
+static int btn_stats_show(struct seq_file *m, void *unused)
+{
+    int i;
+
+    seq_puts(m, "id gpio     irq presses releases\n");
+    for (i = 0; i < ARRAY_SIZE(gpio_btns); i++) {
+        seq_printf(m, "%2u %-8s %3d %7lu %8lu\n", gpio_btns[i].id, gpio_btns[i].con_id,
+                   gpio_btns[i].irq, gpio_btns[i].presses, gpio_btns[i].releases);
+    }
+    seq_printf(m, "queued %d\n", atomic_read(&btn_dev.queued));
+    seq_printf(m, "dropped %d\n", atomic_read(&btn_dev.dropped));
+    mutex_lock(&btn_dev.consumer_lock);
+    seq_printf(m, "delivered %lu\n", btn_dev.delivered);
+    seq_printf(m, "reads %lu\n", btn_dev.reads);
+    mutex_unlock(&btn_dev.consumer_lock);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(btn_stats);
+
+/* IRQ-to-read() latency histogram, in /sys/kernel/debug/gpio_button/latency */
+static int btn_latency_show(struct seq_file *m, void *unused)
+{
+    int i;
+
+    mutex_lock(&btn_dev.consumer_lock);
+    seq_printf(m, "%10s %10s %10s\n", "from_us", "to_us", "count");
+    for (i = 0; i < BTN_LAT_BUCKETS; i++) {
+        if (!btn_dev.lat_hist[i])
+            continue;
+        seq_printf(m, "%10llu %10llu %10llu\n", i ? 1ULL << (i - 1) : 0ULL, 1ULL << i, btn_dev.lat_hist[i]);
+    }
+    seq_printf(m, "max_us %llu\n", btn_dev.lat_max_us);
+    mutex_unlock(&btn_dev.consumer_lock);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(btn_latency);
+
 /* Module initialization */
 static int __init gpio_btn_init(void) {
     pr_info("GPIO Button Driver: Initializing driver\n");
@@ -325,15 +434,27 @@ static int __init gpio_btn_init(void) {
     }
     pr_info("GPIO Button Driver: Device number allocated. Major: %d, Minor: %d\n", MAJOR(btn_dev.dev_num), MINOR(btn_dev.dev_num));
     
-    // Create a device class for this driver
+    // Create a device class for this driver; class_create() lost its module argument in 6.4
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 4, 0)
+    btn_dev.btn_class = class_create("gpio_btn_class");
+#else
     btn_dev.btn_class = class_create(THIS_MODULE, "gpio_btn_class");
+#endif
     if (IS_ERR(btn_dev.btn_class)) {
         pr_err("GPIO Button Driver: Failed to create device class\n");
         goto unregister_dev_num;
     }
 
-    // Create the device file in /dev/
-    if (device_create(btn_dev.btn_class, NULL, btn_dev.dev_num, NULL, "my_button_snake") == NULL) {
+    // Initialize the event queue before any IRQ or reader can use it
+    INIT_KFIFO(btn_dev.events);
+    spin_lock_init(&btn_dev.producer_lock);
+    mutex_init(&btn_dev.consumer_lock);
+    atomic_set(&btn_dev.dropped, 0);
+    atomic_set(&btn_dev.queued, 0);
+    init_waitqueue_head(&btn_dev.event_queue);
+
+    // Create the device file in /dev/ along with its sysfs counters
+    if (IS_ERR_OR_NULL(device_create_with_groups(btn_dev.btn_class, NULL, btn_dev.dev_num, NULL, btn_groups, "my_button_snake"))) {
         pr_err("GPIO Button Driver: Failed to create device file\n");
         goto destroy_class;
     }
@@ -345,13 +466,14 @@ static int __init gpio_btn_init(void) {
         goto unregister_dev_num;
     }
 
+    // Statistics for finding input-latency outliers (debugfs is optional)
+    btn_dev.debug_dir = debugfs_create_dir("gpio_button", NULL);
+    debugfs_create_file("stats", 0444, btn_dev.debug_dir, NULL, &btn_stats_fops);
+    debugfs_create_file("latency", 0444, btn_dev.debug_dir, NULL, &btn_latency_fops);
+
     // Register the platform driver
     platform_driver_register(&gpio_btn_driver);
 
-    // Initialize the wait queue
-    init_waitqueue_head(&btn_dev.event_queue);
-    btn_dev.is_event_ready = false;
-
     pr_info("GPIO Button Driver: Driver initialized successfully\n");
     return 0;
 
@@ -367,6 +489,7 @@ static void __exit gpio_btn_exit(void) {
     pr_info("GPIO Button Driver: Exiting and cleaning up\n");
 
     platform_driver_unregister(&gpio_btn_driver);           // Unregister the platform driver
+    debugfs_remove_recursive(btn_dev.debug_dir);            // Remove the statistics files
     cdev_del(&btn_dev.btn_cdev);                            // Remove the character device
     device_destroy(btn_dev.btn_class, btn_dev.dev_num);     // Destroy the device
     class_destroy(btn_dev.btn_class);                       // Destroy the class
@@ -0,0 +1,59 @@
+/* Tracepoints of the GPIO button driver, under /sys/kernel/tracing/events/gpio_btn/ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM gpio_btn
+
+#if !defined(_BUTTON_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _BUTTON_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* One button edge seen by the hard IRQ handler; queued is false if the event queue was full */
+TRACE_EVENT(gpio_btn_irq,
+    TP_PROTO(u8 id, bool pressed, bool queued),
+    TP_ARGS(id, pressed, queued),
+
+    TP_STRUCT__entry(
+        __field(u8, id)
+        __field(bool, pressed)
+        __field(bool, queued)
+    ),
+
+    TP_fast_assign(
+        __entry->id = id;
+        __entry->pressed = pressed;
+        __entry->queued = queued;
+    ),
+
+    TP_printk("button=%u %s%s", __entry->id, __entry->pressed ? "pressed" : "released",
+              __entry->queued ? "" : " dropped")
+);
+
+/* One event handed to user space by read(), with its IRQ-to-read() latency */
+TRACE_EVENT(gpio_btn_read,
+    TP_PROTO(u8 id, bool pressed, u64 latency_ns),
+    TP_ARGS(id, pressed, latency_ns),
+
+    TP_STRUCT__entry(
+        __field(u8, id)
+        __field(bool, pressed)
+        __field(u64, latency_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->id = id;
+        __entry->pressed = pressed;
+        __entry->latency_ns = latency_ns;
+    ),
+
+    TP_printk("button=%u %s latency_ns=%llu", __entry->id,
+              __entry->pressed ? "pressed" : "released", __entry->latency_ns)
+);
+
+#endif /* _BUTTON_TRACE_H */
+
+/* This part must be outside the include guard */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE button_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,67 @@
+#include <linux/module.h>           /* Defines functions such as module_init/module_exit */
+#include <linux/platform_device.h>  /* For the platform device the button driver binds to */
+#include <linux/gpio/machine.h>     /* For GPIO lookup tables */
+
+/*
+ * Binds button_driver to simulated GPIO lines on a machine without the
+ * BeagleBone's device tree.
+ *
+ * gpio_sim_setup.sh creates a gpio-sim bank labelled `chip` with five
+ * lines; this module maps the driver's "buttonNN" GPIOs onto them in the
+ * order UP, LEFT, RIGHT, DOWN, ENTER and registers a "gpio_button_driver"
+ * platform device, which the driver matches by name. The lines are active
+ * low like on the board, so a press is a pull-down on the simulated line.
+ */
+
+static char *chip = "btn-sim";
+module_param(chip, charp, 0444);
+MODULE_PARM_DESC(chip, "Label of the gpio-sim bank holding the five button lines");
+
+static struct gpiod_lookup_table btn_sim_lookup = {
+    .dev_id = "gpio_button_driver",
+    .table = {
+        GPIO_LOOKUP("btn-sim", 0, "button23", GPIO_ACTIVE_LOW),  // UP
+        GPIO_LOOKUP("btn-sim", 1, "button44", GPIO_ACTIVE_LOW),  // LEFT
+        GPIO_LOOKUP("btn-sim", 2, "button45", GPIO_ACTIVE_LOW),  // RIGHT
+        GPIO_LOOKUP("btn-sim", 3, "button68", GPIO_ACTIVE_LOW),  // DOWN
+        GPIO_LOOKUP("btn-sim", 4, "button69", GPIO_ACTIVE_LOW),  // ENTER
+        { /* sentinel */ }
+    },
+};
+
+static struct platform_device *btn_sim_pdev;
+
+/* Module initialization: the lookup table must exist before the driver probes */
+static int __init btn_sim_init(void)
+{
+    int i;
+
+    for (i = 0; btn_sim_lookup.table[i].con_id; i++) {
+        btn_sim_lookup.table[i].key = chip;
+    }
+    gpiod_add_lookup_table(&btn_sim_lookup);
+
+    btn_sim_pdev = platform_device_register_simple("gpio_button_driver", PLATFORM_DEVID_NONE, NULL, 0);
+    if (IS_ERR(btn_sim_pdev)) {
+        pr_err("Button Sim: Failed to register the platform device\n");
+        gpiod_remove_lookup_table(&btn_sim_lookup);
+        return PTR_ERR(btn_sim_pdev);
+    }
+
+    pr_info("Button Sim: Buttons mapped to lines 0-4 of %s\n", chip);
+    return 0;
+}
+
+/* Module exit function */
+static void __exit btn_sim_exit(void)
+{
+    platform_device_unregister(btn_sim_pdev);
+    gpiod_remove_lookup_table(&btn_sim_lookup);
+}
+
+module_init(btn_sim_init);
+module_exit(btn_sim_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("TungNHS");
+MODULE_DESCRIPTION("gpio-sim bindings for the GPIO button driver");
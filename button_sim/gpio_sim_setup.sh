@@ -0,0 +1,50 @@
+#!/bin/sh
+# Creates five simulated button lines with gpio-sim and binds button_driver to them.
+#
+# usage: gpio_sim_setup.sh [up|down]
+#
+# Needs root, configfs and a kernel with CONFIG_GPIO_SIM (5.17 or later).
+# Build first: make -C button_sim && make -C button_driver host
+# "up" prints the sysfs directory of the simulated chip, to pass to
+# bin/button_sim_bench -d.
+
+set -e
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+CFG=/sys/kernel/config/gpio-sim/snake_buttons
+LABEL=btn-sim
+
+up() {
+    modprobe gpio-sim
+    mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+
+    mkdir -p $CFG/bank0
+    echo 5 > $CFG/bank0/num_lines
+    echo $LABEL > $CFG/bank0/label
+    echo 1 > $CFG/live
+
+    # Buttons are active low: idle lines are pulled up before the driver requests them
+    SIM=/sys/devices/platform/$(cat $CFG/dev_name)/$(cat $CFG/bank0/chip_name)
+    for i in 0 1 2 3 4; do
+        echo pull-up > $SIM/sim_gpio$i/pull
+    done
+
+    insmod "$DIR/btn_sim.ko" chip=$LABEL
+    insmod "$DIR/../button_driver/button_driver.ko"
+    echo "$SIM"
+}
+
+down() {
+    rmmod button_driver 2>/dev/null || true
+    rmmod btn_sim 2>/dev/null || true
+    if [ -d $CFG ]; then
+        echo 0 > $CFG/live
+        rmdir $CFG/bank0 $CFG
+    fi
+}
+
+case "${1:-up}" in
+    up) up ;;
+    down) down ;;
+    *) echo "usage: $0 [up|down]" >&2; exit 1 ;;
+esac
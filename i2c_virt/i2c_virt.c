@@ -0,0 +1,118 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/i2c.h>           // Provides the I2C adapter and client interfaces
+#include <linux/version.h>       // For the kernel API differences between versions
+
+/*
+ * Virtual I2C adapter for testing the OLED driver without a panel.
+ *
+ * Registers an adapter that acknowledges every write to `addr` and creates a
+ * `device` client on it, so oled_driver binds through its i2c_device_id table
+ * on any Linux machine. Reads return zeros. The traffic seen on the bus is
+ * counted in /sys/module/i2c_virt/parameters/{xfers,bytes}, to cross-check
+ * the driver's own counters.
+ */
+
+static unsigned short addr = 0x3c;
+module_param(addr, ushort, 0444);
+MODULE_PARM_DESC(addr, "Address of the emulated device (default 0x3c)");
+
+static char *device = "ssd1306";
+module_param(device, charp, 0444);
+MODULE_PARM_DESC(device, "Client to instantiate on the adapter (default ssd1306)");
+
+static unsigned long xfers;
+module_param(xfers, ulong, 0444);
+MODULE_PARM_DESC(xfers, "I2C messages acknowledged so far");
+
+static unsigned long bytes;
+module_param(bytes, ulong, 0444);
+MODULE_PARM_DESC(bytes, "Payload bytes acknowledged so far");
+
+static struct i2c_adapter *virt_adapter;
+static struct i2c_client *virt_client;
+
+/* Transfer function - Acknowledges messages to the emulated address, NAKs everything else */
+static int virt_xfer(struct i2c_adapter *adapter, struct i2c_msg *msgs, int num)
+{
+    int i;
+
+    for (i = 0; i < num; i++) {
+        if (msgs[i].addr != addr) {
+            return -ENXIO;  /* No device at this address */
+        }
+        if (msgs[i].flags & I2C_M_RD) {
+            memset(msgs[i].buf, 0, msgs[i].len);
+        }
+        xfers++;
+        bytes += msgs[i].len;
+    }
+
+    return num;
+}
+
+static u32 virt_functionality(struct i2c_adapter *adapter)
+{
+    return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+}
+
+static const struct i2c_algorithm virt_algorithm = {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+    .xfer = virt_xfer,           // Renamed from master_xfer in 6.8
+#else
+    .master_xfer = virt_xfer,
+#endif
+    .functionality = virt_functionality,
+};
+
+/* Module init function - Registers the adapter and the emulated device */
+static int __init virt_init(void)
+{
+    struct i2c_board_info info = { };
+    int ret;
+
+    virt_adapter = kzalloc(sizeof(*virt_adapter), GFP_KERNEL);
+    if (!virt_adapter) {
+        return -ENOMEM;
+    }
+
+    virt_adapter->owner = THIS_MODULE;
+    virt_adapter->algo = &virt_algorithm;
+    strscpy(virt_adapter->name, "i2c-virt", sizeof(virt_adapter->name));
+
+    ret = i2c_add_adapter(virt_adapter);
+    if (ret) {
+        pr_err("i2c-virt: Failed to add adapter\n");
+        kfree(virt_adapter);
+        return ret;
+    }
+
+    strscpy(info.type, device, sizeof(info.type));
+    info.addr = addr;
+    virt_client = i2c_new_client_device(virt_adapter, &info);
+    if (IS_ERR(virt_client)) {
+        pr_err("i2c-virt: Failed to create %s at 0x%02x\n", device, addr);
+        i2c_del_adapter(virt_adapter);
+        kfree(virt_adapter);
+        return PTR_ERR(virt_client);
+    }
+
+    pr_info("i2c-virt: %s at 0x%02x on i2c-%d\n", device, addr, virt_adapter->nr);
+    return 0;
+}
+
+/* Module exit function - Removes the device, then the adapter */
+static void __exit virt_exit(void)
+{
+    i2c_unregister_device(virt_client);
+    i2c_del_adapter(virt_adapter);
+    kfree(virt_adapter);
+}
+
+module_init(virt_init);
+module_exit(virt_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("TungNHS");
+MODULE_DESCRIPTION("Virtual I2C adapter for testing the SSD1306 driver");
@@ -18,6 +18,12 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <termios.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+
+#include "button_event.h"   // Event records returned by the button driver
 
 // Define the path to the button device file for handling button inputs.
 #define SSD1306_BUTTON_FILE "/dev/my_button_snake"
@@ -29,22 +35,45 @@
 #define DOWN        4
 #define ENTER       5
 
-// Function to open the button device file.
+// Returned instead of a button once the input has ended, e.g. at the end of an input script.
+#define BUTTON_EOF  (-2)
+
+/*
+ * Backends button events can come from, picked with Button_SetBackend() or the
+ * SNAKE_INPUT environment variable:
+ *   dev           - the button device file (default)
+ *   script:<path> - presses replayed from a text file, one "<delay_ms> <button>" per line
+ * Every backend returns a pollable fd delivering struct btn_event records.
+ */
+typedef struct {
+    const char *name;
+    int (*open)(const char *arg);   // arg is the text after "name:", or NULL
+} Button_Backend;
+
+// Function to select the input backend, e.g. "dev" or "script:moves.txt". Returns -1 if unknown.
+int Button_SetBackend(const char *spec);
+
+// Function to open the button device file (or the selected input backend).
 int Button_OpenDevFile();
 
-// Function to read data from the button device file.
+// Function to read the next event record (press or release) from the button device file.
+// Returns 1 if an event was read, 0 once the input has ended, -1 if no event is available.
+int Button_ReadEvent(int fdt, struct btn_event *event);
+
+// Function to read data from the button device file; returns BUTTON_EOF once the input has ended.
 int Button_Read(int fdt, char *buff, size_t size);
 
-// Function to check if any button is pressed.
+// Function to check if any button is pressed; returns BUTTON_EOF once the input has ended.
 int Button_CheckAnyPress(int fd, char *buff, size_t size);
 
 // Function to process and identify which button was pressed from the buffer.
 int Button_Press(char *buff);
 
-// Function to wait until any button is pressed.
+// Function to wait until any button is pressed; returns BUTTON_EOF once the input has ended.
 int Button_WaitForAnyKey(int fd, char *buff, size_t size);
 
 // Function to convert pressed keys into the corresponding direction (up, down, left, right, or enter).
+// Returns BUTTON_EOF once the input has ended.
 int Button_KeysPressedToDirection(int fd, char *buff, size_t size, int direction);
 
 #endif
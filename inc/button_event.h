@@ -0,0 +1,27 @@
+#ifndef BUTTON_EVENT_H
+#define BUTTON_EVENT_H
+
+/*
+ * Event records returned by read() on /dev/my_button_snake.
+ *
+ * A read() with room for at least one struct btn_event returns as many
+ * whole records as are queued and fit. A shorter read() keeps the legacy
+ * format: one ASCII digit ('1'..'5') for the next press, releases skipped.
+ *
+ * This header is shared by the kernel driver and the user-space library.
+ */
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+struct btn_event {
+    uint8_t id;             // Button number, 1..5 (UP, LEFT, RIGHT, DOWN, ENTER)
+    uint8_t pressed;        // 1 = pressed, 0 = released
+    uint8_t reserved[6];    // Keeps ts_ns 8-byte aligned
+    int64_t ts_ns;          // CLOCK_MONOTONIC time of the edge, in nanoseconds
+};
+
+#endif
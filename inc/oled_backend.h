@@ -0,0 +1,46 @@
+#ifndef OLED_BACKEND_H
+#define OLED_BACKEND_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define OLED_WIDTH      128     // Columns of the panel
+#define OLED_PAGES      8       // 8-pixel pages of the panel (64 rows)
+
+/*
+ * A backend receives the byte stream the OLED_* functions would write to
+ * /dev/my_ssd1306_device (text commands and binary batches).
+ *
+ *   dev  - the real device file (default)
+ *   mem  - an in-memory 128x64 framebuffer that interprets the stream like the driver
+ *   term - the in-memory framebuffer, redrawn on an ANSI terminal (changed cells only)
+ *   null - discards the stream (benchmarks)
+ *
+ * The backend is picked with OLED_SetBackend() or the SNAKE_OLED environment variable.
+ */
+typedef struct {
+    const char *name;
+    int (*open)(void);                                      // Returns the fd used by the OLED_* functions
+    ssize_t (*write)(int fd, const void *buf, size_t len);  // Sends one command or batch
+    int (*sync)(int fd);                                    // Waits until everything written is displayed
+} OLED_Backend;
+
+// Selects a backend by name; returns -1 if the name is unknown.
+int OLED_SetBackend(const char *name);
+
+// Returns the selected backend, picking it from SNAKE_OLED (default "dev") on first use.
+const OLED_Backend *OLED_GetBackend(void);
+
+// Sends bytes to the selected backend.
+ssize_t OLED_Write(int fd, const void *buf, size_t len);
+
+// Number of OLED_Write() calls so far (write() syscalls with the dev backend).
+unsigned long OLED_WriteCount(void);
+
+// Waits until everything written to the selected backend is displayed.
+int OLED_Sync(int fd);
+
+// Page-packed contents of the in-memory framebuffer (mem and term backends).
+const unsigned char (*OLED_MemFrame(void))[OLED_WIDTH];
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef OLED_BLIT_H
+#define OLED_BLIT_H
+
+#include <stdint.h>
+
+#include "oled_i2c_ssd1306.h"  // OLED_Frame
+
+/*
+ * A 1bpp sprite in the panel's page-packed layout: (h + 7) / 8 pages of w
+ * column bytes each, bit 0 of a byte being the top row of its page. Bits
+ * below row h in the last page must be 0.
+ */
+typedef struct {
+    uint8_t w;              // Width in pixels
+    uint8_t h;              // Height in pixels
+    const uint8_t *data;    // Page 0 columns, then page 1 columns, ...
+} OLED_Sprite;
+
+/*
+ * Turn on the sprite's set pixels with its top left corner at (x, y), any
+ * pixel position, clipped to the panel. Whole rows of columns are shifted
+ * between pages at once (NEON on ARM, 64-bit words elsewhere).
+ */
+void OLED_FrameBlit(OLED_Frame *frame, int x, int y, const OLED_Sprite *sprite);
+
+/*
+ * Turn off the sprite's set pixels at (x, y).
+ */
+void OLED_FrameErase(OLED_Frame *frame, int x, int y, const OLED_Sprite *sprite);
+
+#endif
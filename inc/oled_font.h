@@ -0,0 +1,11 @@
+#ifndef OLED_FONT_H
+#define OLED_FONT_H
+
+#define OLED_FONT_WIDTH     5     // Columns per glyph
+#define OLED_FONT_FIRST     ' '   // First character in the table
+#define OLED_FONT_LAST      '~'   // Last character in the table
+
+// 5x8 glyphs for ' '..'~', one byte per column, bit 0 is the top pixel row.
+extern const unsigned char OLED_Font[][OLED_FONT_WIDTH];
+
+#endif
@@ -4,6 +4,25 @@
 
 // Standard include guard for compatibility, ensuring the header file is included only once.
 #include "button.h"  // Include the header file for button-related functionality, allowing interaction with button inputs.
+#include "ssd1306_batch.h"  // Binary batch protocol understood by the OLED driver
+#include "oled_backend.h"  // Panel size
+
+// A batch of display operations sent to the OLED driver in a single write().
+typedef struct {
+    int fd;                                 // Device file the batch is flushed to
+    size_t len;                             // Bytes used in buf, magic byte included
+    unsigned char buf[SSD1306_BATCH_MAX];   // Magic byte followed by packed records
+} OLED_Batch;
+
+// A whole 128x64 1bpp frame kept in memory; OLED_FrameEnd() sends only what changed.
+typedef struct {
+    int fd;                                         // Device file the frame is sent to
+    int known;                                      // shown[] matches the panel
+    unsigned char dirtyFrom[OLED_PAGES];            // Columns [dirtyFrom, dirtyTo) of each page were drawn
+    unsigned char dirtyTo[OLED_PAGES];              // since the last OLED_FrameEnd(); empty if From >= To
+    unsigned char pix[OLED_PAGES][OLED_WIDTH];      // Frame being drawn, page-packed like GDDRAM
+    unsigned char shown[OLED_PAGES][OLED_WIDTH];    // Last frame sent
+} OLED_Frame;
 
 
 // Function declarations for interacting with the OLED display:
@@ -20,4 +39,53 @@ void OLED_Display(int fd, char *str);
 // Clears the OLED display screen.
 void OLED_Clear(int fd);
 
+// Starts an empty batch for the OLED device `fd`.
+void OLED_BatchBegin(OLED_Batch *batch, int fd);
+
+// Queues a cursor move to (x, y).
+void OLED_BatchSetCursor(OLED_Batch *batch, int x, int y);
+
+// Queues `str` to be printed at the current cursor position.
+void OLED_BatchDisplay(OLED_Batch *batch, const char *str);
+
+// Queues a full screen clear.
+void OLED_BatchClear(OLED_Batch *batch);
+
+// Queues `len` raw column bytes for page `page`, starting at column `x`.
+void OLED_BatchBlit(OLED_Batch *batch, int x, int page, const unsigned char *data, int len);
+
+// Queues a clear of page (text line) `page`.
+void OLED_BatchClearPage(OLED_Batch *batch, int page);
+
+// Sends all queued operations in one write() and empties the batch.
+int OLED_BatchFlush(OLED_Batch *batch);
+
+// Starts diffing frames for the OLED device `fd`, whose screen has just been cleared.
+void OLED_FrameInit(OLED_Frame *frame, int fd);
+
+// Forgets what is on the panel, so the next OLED_FrameEnd() sends the whole frame.
+void OLED_FrameInvalidate(OLED_Frame *frame);
+
+// Starts a new frame with every pixel off, to redraw the whole screen (menus, a new round).
+// Without it, drawing changes the last frame in place and only the touched columns are compared.
+void OLED_FrameBegin(OLED_Frame *frame);
+
+// Marks columns [x0, x1) of page `page` as drawn; the OLED_Frame* drawing functions call it.
+void OLED_FrameTouch(OLED_Frame *frame, int page, int x0, int x1);
+
+// Turns the pixel at (x, y) on or off.
+void OLED_FramePixel(OLED_Frame *frame, int x, int y, int on);
+
+// Turns a w x h rectangle of pixels with its top left corner at (x, y) on or off.
+void OLED_FrameFill(OLED_Frame *frame, int x, int y, int w, int h, int on);
+
+// Draws `str` at column x of text line `line`, with the same font and spacing as the driver.
+void OLED_FrameText(OLED_Frame *frame, int x, int line, const char *str);
+
+// Draws a sprite 8 pixels high and `w` columns wide (one byte per column, bit 0 on top) at (x, y).
+void OLED_FrameSprite(OLED_Frame *frame, int x, int y, const unsigned char *cols, int w);
+
+// Sends the drawn columns that differ from the last frame in one batch.
+int OLED_FrameEnd(OLED_Frame *frame);
+
 #endif
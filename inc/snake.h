@@ -3,77 +3,81 @@
 
 #include "button.h"
 #include "oled_i2c_ssd1306.h"
-
-#define SNAKE_ARRAY_SIZE 310  // Maximum snake array size
-
-/*
- * Get the game speed.
- */
-int Snake_GetGameSpeed();
-
-/*
- * Check if the snake has collided with itself.
- */
-int Snake_CheckCollision(int x, int y, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength, int detect);
+#include "snake_engine.h"   // Game rules, shared with headless tools
+#include "snake_replay.h"   // Recording and playback of games
+#include "snake_autopilot.h"  // Computer player
+#include "snake_stats.h"    // Game loop telemetry for snakestat
 
 /*
- * Generate food at a random position.
+ * Everything one game session needs. Nothing is kept in globals, so several
+ * sessions (or headless tools) can run side by side.
  */
-void Snake_GenerateFood(int fd, int foodXY[], int width, int height, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength);
+typedef struct {
+    int fds;            // OLED display
+    int fdb;            // Button device
+    char buff[2];       // Last key read from the buttons
+    OLED_Frame frame;   // Board as last sent to the display
+    uint32_t seed;      // Seed for the next round, 0 picks one from the clock
+    Snake_State state;  // Current round
+    Snake_Recorder recorder;  // Log every round to SNAKE_RECORD, if set
+    Snake_Replay replay;      // Play rounds from SNAKE_REPLAY instead of the buttons, if set
+    Snake_Autopilot *autopilot;  // Steers instead of the buttons if SNAKE_AUTOPILOT is set
+    long planWorstNs;         // Longest autopilot planning time this round
+    Snake_Stats *stats;       // Tick telemetry page named by SNAKE_STATS, if set
+} Snake_Game;
 
 /*
- * Initialize the snake array.
+ * Set up a session on an opened display and button device, recording or
+ * replaying if SNAKE_RECORD or SNAKE_REPLAY name a log file, and letting the
+ * autopilot play if SNAKE_AUTOPILOT is set.
  */
-void Snake_PrepareArray(int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength);
+void Snake_InitGame(Snake_Game *game, int fds, int fdb);
 
 /*
- * Move the snake by updating its position.
+ * Wait until any button is pressed and return it, or BUTTON_EOF once the
+ * input has ended. When replaying, pause briefly and answer ENTER while the
+ * log has more rounds; the autopilot always answers ENTER, so it plays forever.
  */
-void Snake_MoveArray(int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength, int direction);
+int Snake_WaitForKey(Snake_Game *game);
 
 /*
- * Move the snake and update the display.
- */
-void Snake_Move(int fd, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength, int direction);
-
-/*
- * Check if the snake has eaten food.
+ * Get the game speed.
  */
-int Snake_EatFood(int snakeXY[][SNAKE_ARRAY_SIZE], int foodXY[]);
+int Snake_GetGameSpeed();
 
 /*
- * Detect collisions with walls or itself.
+ * Step the game, draw the cells it changed over the last frame and send what changed.
  */
-int Snake_CollisionDetection(int snakeXY[][SNAKE_ARRAY_SIZE], int ScreenWidth, int ScreenHeight, int snakeLength);
+int Snake_Move(OLED_Frame *frame, Snake_State *state, int input);
 
 /*
- * Load the snake on the display.
+ * Load the snake on the display, redrawing the whole frame.
  */
-void Snake_Load(int fd, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength);
+void Snake_Load(OLED_Frame *frame, const Snake_State *state);
 
 /*
- * Refresh the information bar (score and speed).
+ * Draw the information bar (score and speed) into the frame.
  */
-void Snake_RefreshInfoBar(int fd, int score, int speed);
+void Snake_RefreshInfoBar(OLED_Frame *frame, int score, int speed);
 
 /*
  * Display the game over screen.
  */
-void Snake_GameOver(int fds, int fdb, char *buff, size_t size);
+void Snake_GameOverScreen(Snake_Game *game);
 
 /*
  * Display the game win screen.
  */
-void Snake_GameWin(int fds, int fdb, char *buff, size_t size);
+void Snake_GameWin(Snake_Game *game);
 
 /*
  * Start the snake game.
  */
-void Snake_Start(int fds, int fdb, char *buff, size_t size, int snakeXY[][SNAKE_ARRAY_SIZE], int foodXY[], int ScreenWidth, int ScreenHeight, int snakeLength, int direction, int score, int speed);
+void Snake_StartGame(Snake_Game *game);
 
 /*
  * Load the game setup.
  */
-void Snake_LoadGame(int fds, int fdb, char *buff, size_t size);
+void Snake_LoadGame(Snake_Game *game);
 
 #endif
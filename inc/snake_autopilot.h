@@ -0,0 +1,45 @@
+#ifndef SNAKE_AUTOPILOT_H
+#define SNAKE_AUTOPILOT_H
+
+#include <stdint.h>
+
+#include "snake_engine.h"
+
+/*
+ * Autopilot that plays the game through the same direction input as the buttons.
+ *
+ * It keeps the snake on a Hamiltonian cycle of the board: the body always
+ * covers a stretch of the cycle ending at the head, so following the cycle
+ * can never trap it. Towards the food it takes shortcuts found by a BFS that
+ * only moves forward along the cycle and never passes the tail, then checks
+ * that the tail is still reachable from where the path ends. When no such
+ * path exists it follows the cycle until that food is eaten.
+ *
+ * A path is planned once per food, failed or not, and then followed, so most
+ * ticks cost a table lookup. A planning tick is two flood fills over the board.
+ */
+
+typedef struct {
+    uint16_t cycle[SNAKE_CELLS];      // Position of each cell on the cycle
+    uint16_t cycleCell[SNAKE_CELLS];  // Cell at each cycle position
+    int hasCycle;                     // 0 if both board sides are odd and no cycle exists
+    uint16_t path[SNAKE_CELLS];       // Planned cells, starting next to the head
+    int pathLen;
+    int pathPos;                      // Next cell of path to move to
+    int foodCell;                     // Food the path was planned for
+    uint32_t plans;                   // Paths planned
+    uint32_t rejected;                // Paths dropped by the tail check
+    uint32_t cycleMoves;              // Ticks that followed the cycle
+} Snake_Autopilot;
+
+/*
+ * Build the cycle for the configured board.
+ */
+void Snake_AutopilotInit(Snake_Autopilot *ap);
+
+/*
+ * Pick the input for the next tick: a direction, or SNAKE_NONE to keep going straight.
+ */
+int Snake_AutopilotPlan(Snake_Autopilot *ap, const Snake_State *state);
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef SNAKE_ENGINE_H
+#define SNAKE_ENGINE_H
+
+#include <stdint.h>
+
+/*
+ * Game rules without any I/O. The whole game lives in a Snake_State and only
+ * changes through Snake_Step(), so the same seed and inputs always replay the
+ * same game, on the board or on a host.
+ */
+
+#define SNAKE_ARRAY_SIZE    310   // Maximum snake array size
+
+/*
+ * Board geometry, fixed at compile time. The default 5x8 cell is one text
+ * glyph per cell; smaller cells (e.g. -DSNAKE_CELL_PX=2 -DSNAKE_CELL_PY=2
+ * for a 64x28 board) are drawn as sprites. Rows 56-63 are the info bar.
+ */
+#ifndef SNAKE_CELL_PX
+#define SNAKE_CELL_PX       5     // Pixel width of a cell on the OLED
+#endif
+#ifndef SNAKE_CELL_PY
+#define SNAKE_CELL_PY       8     // Pixel height of a cell on the OLED
+#endif
+#ifndef SNAKE_BOARD_W
+#if SNAKE_CELL_PX == 5
+#define SNAKE_BOARD_W       26    // Board width in cells (5-pixel glyph columns, the last one clipped)
+#else
+#define SNAKE_BOARD_W       (128 / SNAKE_CELL_PX)
+#endif
+#endif
+#ifndef SNAKE_BOARD_H
+#define SNAKE_BOARD_H       (56 / SNAKE_CELL_PY)  // Board height in cells, above the info bar
+#endif
+#define SNAKE_CELLS         (SNAKE_BOARD_W * SNAKE_BOARD_H)
+#define SNAKE_OCC_WORDS     ((SNAKE_CELLS + 63) / 64)  // 64-bit words in the occupancy grid
+
+// The snake wins when it reaches this length or fills the board
+#define SNAKE_WIN_LENGTH    (SNAKE_ARRAY_SIZE - 5 < SNAKE_CELLS ? SNAKE_ARRAY_SIZE - 5 : SNAKE_CELLS)
+
+// Body ring slots: a power of two above SNAKE_WIN_LENGTH, the extra slot keeps the cell the tail left
+#if SNAKE_WIN_LENGTH < 256
+#define SNAKE_RING_SIZE     256
+#else
+#define SNAKE_RING_SIZE     512
+#endif
+#define SNAKE_RING_MASK     (SNAKE_RING_SIZE - 1)
+
+// Cells are stored as a single index y * SNAKE_BOARD_W + x
+#if SNAKE_CELLS < 255
+typedef uint8_t Snake_Cell;
+#define SNAKE_CELL_NONE     0xFF    // A head that left the board
+#else
+typedef uint16_t Snake_Cell;
+#define SNAKE_CELL_NONE     0xFFFF
+#endif
+
+/*
+ * Directions, same values as the UP/LEFT/RIGHT/DOWN buttons.
+ */
+#define SNAKE_NONE          0     // Keep the current direction
+#define SNAKE_UP            1
+#define SNAKE_LEFT          2
+#define SNAKE_RIGHT         3
+#define SNAKE_DOWN          4
+
+/*
+ * Game status, same values as the game over codes of Snake_StartGame().
+ */
+#define SNAKE_RUNNING       0
+#define SNAKE_LOST          1
+#define SNAKE_WON           2
+
+/*
+ * Events reported by Snake_Step().
+ */
+#define SNAKE_EV_ATE        0x01  // The head reached the food and the snake grew
+#define SNAKE_EV_SPEEDUP    0x02  // speed and waitMili changed
+#define SNAKE_EV_LOST       0x04  // Hit a wall or itself
+#define SNAKE_EV_WON        0x08  // Reached SNAKE_WIN_LENGTH
+
+/*
+ * Packed game state: small enough to copy, hash and compare thousands of
+ * times per tick. Fields are ordered by size so there is no padding.
+ */
+typedef struct {
+    uint64_t occupied[SNAKE_OCC_WORDS];  // One bit per cell covered by a segment
+    uint32_t rng;                        // xorshift32 state, never 0
+    uint32_t ticks;                      // Steps taken
+    uint16_t score;
+    uint16_t tempScore;                  // Score at the last speed-up
+    int16_t waitMili;                    // Tick period in milliseconds
+    uint16_t length;                     // Number of segments
+    uint16_t head;                       // Ring slot of the head; segment i is at head - i
+    Snake_Cell food;                     // Food cell
+    uint8_t direction;                   // SNAKE_UP..SNAKE_DOWN
+    uint8_t speed;                       // 1-9 and beyond, raised as the score grows
+    uint8_t status;                      // SNAKE_RUNNING, SNAKE_LOST or SNAKE_WON
+    Snake_Cell body[SNAKE_RING_SIZE];    // Segment cells in a ring, see Snake_SegmentCell()
+} Snake_State;
+
+_Static_assert((SNAKE_RING_SIZE & SNAKE_RING_MASK) == 0 && SNAKE_RING_SIZE > SNAKE_WIN_LENGTH,
+               "SNAKE_RING_SIZE must be a power of two above SNAKE_WIN_LENGTH");
+#if SNAKE_CELLS < 255
+_Static_assert(sizeof(Snake_State) <= 512, "Snake_State should stay within 512 bytes");
+#endif
+
+/*
+ * Cell of segment i, 0 being the head. Segment length is the cell the tail
+ * left on the last step (still in the ring until it is overwritten).
+ */
+static inline int Snake_SegmentCell(const Snake_State *state, int i) {
+    return state->body[(state->head - i) & SNAKE_RING_MASK];
+}
+
+static inline int Snake_SegmentX(const Snake_State *state, int i) {
+    return Snake_SegmentCell(state, i) % SNAKE_BOARD_W;
+}
+
+static inline int Snake_SegmentY(const Snake_State *state, int i) {
+    return Snake_SegmentCell(state, i) / SNAKE_BOARD_W;
+}
+
+static inline int Snake_FoodX(const Snake_State *state) {
+    return state->food % SNAKE_BOARD_W;
+}
+
+static inline int Snake_FoodY(const Snake_State *state) {
+    return state->food / SNAKE_BOARD_W;
+}
+
+/*
+ * Copy a game, e.g. before a lookahead, and put it back afterwards. A plain
+ * memcpy: the state has no pointers.
+ */
+static inline void Snake_Snapshot(const Snake_State *state, Snake_State *snapshot) {
+    *snapshot = *state;
+}
+
+static inline void Snake_Restore(Snake_State *state, const Snake_State *snapshot) {
+    *state = *snapshot;
+}
+
+/*
+ * Occupancy grid lookups. Cells outside the board are never occupied.
+ */
+static inline int Snake_InBoard(int x, int y) {
+    return x >= 0 && y >= 0 && x < SNAKE_BOARD_W && y < SNAKE_BOARD_H;
+}
+
+static inline int Snake_TestCell(const Snake_State *state, int x, int y) {
+    int cell = y * SNAKE_BOARD_W + x;
+    return Snake_InBoard(x, y) && ((state->occupied[cell / 64] >> (cell % 64)) & 1);
+}
+
+/*
+ * Number of board cells not covered by the snake.
+ */
+int Snake_CountFree(const Snake_State *state);
+
+/*
+ * Start a new game with the given seed and speed.
+ */
+void Snake_Init(Snake_State *state, uint32_t seed, int speed);
+
+/*
+ * Advance the game by one tick, turning first if input is a valid new direction.
+ * Returns a mask of SNAKE_EV_* events.
+ */
+int Snake_Step(Snake_State *state, int input);
+
+/*
+ * FNV-1a hash of everything that decides how the game continues.
+ */
+uint64_t Snake_Hash(const Snake_State *state);
+
+/*
+ * Next number from the game's xorshift32 generator.
+ */
+uint32_t Snake_Random(Snake_State *state);
+
+/*
+ * Apply a requested direction unless it reverses the current one.
+ */
+int Snake_TurnDirection(int direction, int input);
+
+/*
+ * Check if the cell (x, y) is covered by the snake.
+ */
+int Snake_CheckCollisionWithBody(const Snake_State *state, int x, int y);
+
+/*
+ * Place the food on a cell picked uniformly from the free cells, selecting
+ * the n-th zero bit of the occupancy grid with popcounts. O(SNAKE_OCC_WORDS):
+ * one popcount per grid word to count and find the word, then up to 63 bit
+ * drops inside it. Not constant time, but independent of the snake's length.
+ */
+void Snake_GenerateFood(Snake_State *state);
+
+/*
+ * Lay out the body behind the head, facing right, and fill the occupancy grid.
+ */
+void Snake_PrepareArray(Snake_State *state);
+
+/*
+ * Move the snake one cell in the given direction by pushing a new head.
+ * Constant time: the tail is dropped just by not counting it in length, and
+ * its cell is freed in the occupancy grid. The new head is not marked yet;
+ * Snake_Step() marks it once it knows the move didn't collide.
+ */
+void Snake_MoveArray(Snake_State *state, int direction);
+
+/*
+ * Check if the head is on the food.
+ */
+int Snake_EatFood(const Snake_State *state);
+
+/*
+ * Detect collisions of the head with the walls or the body, before the head is marked.
+ */
+int Snake_CollisionDetection(const Snake_State *state);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SNAKE_REPLAY_H
+#define SNAKE_REPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "snake_engine.h"
+
+/*
+ * Replay logs. A log is a sequence of games, each written as:
+ *
+ *   header  "SNKR", version (1 byte), seed (4 bytes LE), speed (1 byte)
+ *   inputs  varint(1 + (tick_delta << 2 | (direction - 1))) per direction input,
+ *           tick_delta counting ticks since the previous input of the game
+ *   end     0x00, varint(ticks), Snake_Hash() of the final state (8 bytes LE)
+ *
+ * Since the engine is deterministic, the seed, speed and inputs are enough to
+ * re-run the game, and the end record lets playback prove it got the same result.
+ */
+
+#define SNAKE_REPLAY_MAGIC      "SNKR"
+#define SNAKE_REPLAY_VERSION    2
+
+typedef struct {
+    FILE *file;           // NULL when not recording
+    uint32_t lastTick;    // Tick of the previous input
+} Snake_Recorder;
+
+typedef struct {
+    FILE *file;           // NULL when not replaying
+    uint32_t seed;        // Header of the current game
+    int speed;
+    uint32_t lastTick;    // Tick of the previous input
+    int hasInput;         // inputTick/inputDir hold an input not yet returned
+    uint32_t inputTick;
+    int inputDir;
+    int ended;            // 1 after the end record, -1 if the log is damaged
+    uint32_t endTicks;    // From the end record
+    uint64_t endHash;
+} Snake_Replay;
+
+/*
+ * Open a log for appending, with a large stdio buffer. Returns -1 on error.
+ */
+int Snake_RecordOpen(Snake_Recorder *rec, const char *path);
+
+/*
+ * Start a new game in the log.
+ */
+void Snake_RecordGame(Snake_Recorder *rec, uint32_t seed, int speed);
+
+/*
+ * Log a direction input that was applied at the given tick.
+ */
+void Snake_RecordInput(Snake_Recorder *rec, uint32_t tick, int direction);
+
+/*
+ * Close the current game with the final state's hash, and flush it.
+ */
+void Snake_RecordEnd(Snake_Recorder *rec, const Snake_State *state);
+
+void Snake_RecordClose(Snake_Recorder *rec);
+
+/*
+ * Open a log for playback. Returns -1 on error.
+ */
+int Snake_ReplayOpen(Snake_Replay *rp, const char *path);
+
+/*
+ * Move to the next game in the log, skipping what is left of the current one.
+ * Returns 1 if a game header was read, 0 at the end of the log, -1 if it is damaged.
+ */
+int Snake_ReplayNextGame(Snake_Replay *rp);
+
+/*
+ * Check if the log holds another game after the current one.
+ */
+int Snake_ReplayMore(Snake_Replay *rp);
+
+/*
+ * Direction input to apply at the given tick, or SNAKE_NONE.
+ */
+int Snake_ReplayInput(Snake_Replay *rp, uint32_t tick);
+
+/*
+ * Check if the current game's end record says it stopped at the given tick,
+ * e.g. a round cut short when the input ran out.
+ */
+int Snake_ReplayEnded(Snake_Replay *rp, uint32_t tick);
+
+/*
+ * Compare a finished game with the log's end record. Returns 0 if it matches.
+ */
+int Snake_ReplayCheck(Snake_Replay *rp, const Snake_State *state);
+
+void Snake_ReplayClose(Snake_Replay *rp);
+
+#endif
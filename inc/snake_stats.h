@@ -0,0 +1,78 @@
+#ifndef SNAKE_STATS_H
+#define SNAKE_STATS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "snake_engine.h"
+
+/*
+ * Game loop telemetry in a POSIX shared memory page (/dev/shm/<name>), so
+ * snakestat can watch a running game without slowing it down.
+ *
+ * The game is the only writer and updates the page once per tick under a
+ * seqlock: seq is odd while an update is in progress. Readers copy the page
+ * with Snake_StatsRead() and retry if seq changed, so they never block it.
+ *
+ * Times are CLOCK_MONOTONIC. A tick is late by the time between its timer
+ * expiry and the loop handling it. Its render time covers Snake_Move(),
+ * the info bar and the device writes of the frame.
+ */
+
+#define SNAKE_STATS_NAME        "/snake_stats"  // Default shared memory object
+#define SNAKE_STATS_MAGIC       0x54534E53      // "SNST"
+#define SNAKE_STATS_VERSION     1
+#define SNAKE_STATS_BUCKETS     20              // Bucket n counts values in [2^(n-1), 2^n), the last one is open
+
+typedef struct {
+    uint64_t count[SNAKE_STATS_BUCKETS];
+    uint64_t sum;
+    uint64_t max;
+} Snake_Histogram;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    _Atomic uint32_t seq;       // Odd while the game updates the page
+    uint32_t pid;               // Process of the game
+    uint32_t rounds;            // Rounds started
+    uint32_t ticks;             // Ticks of the current round
+    uint32_t speed;             // Current round
+    uint32_t waitMili;
+    uint32_t score;
+    uint32_t length;
+    uint32_t status;
+    uint32_t pad;
+    uint64_t totalTicks;        // Ticks of all rounds
+    uint64_t missed;            // Timer expirations the loop fell behind by
+    uint64_t overruns;          // Ticks whose lateness plus render time exceeded the tick period
+    uint64_t updatedNs;         // CLOCK_MONOTONIC time of the last update
+    Snake_Histogram lateUs;     // Tick lateness, microseconds
+    Snake_Histogram renderUs;   // Render time per frame, microseconds
+    Snake_Histogram writes;     // Device writes per frame
+} Snake_Stats;
+
+// CLOCK_MONOTONIC time in nanoseconds.
+uint64_t Snake_StatsNow(void);
+
+// Creates (or reuses) and maps the page of the writer; returns NULL on failure.
+Snake_Stats *Snake_StatsOpen(const char *name);
+
+// Maps the page of a running game read-only; returns NULL on failure.
+const Snake_Stats *Snake_StatsAttach(const char *name);
+
+// Starts a new round.
+void Snake_StatsRound(Snake_Stats *stats, const Snake_State *state);
+
+// Accounts one tick: its lateness, the extra expirations read with it, its render time and writes.
+void Snake_StatsTick(Snake_Stats *stats, const Snake_State *state, uint64_t lateNs, uint64_t missed,
+                     uint64_t renderNs, unsigned long writes);
+
+// Takes a consistent copy of the page; returns -1 if it is not a stats page of this version
+// or the writer stayed in the middle of an update.
+int Snake_StatsRead(const Snake_Stats *stats, Snake_Stats *copy);
+
+// Upper bound of the bucket holding the `percent` percentile, at most the largest value; 0 if empty.
+uint64_t Snake_StatsPercentile(const Snake_Histogram *hist, double percent);
+
+#endif
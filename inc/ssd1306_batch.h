@@ -0,0 +1,46 @@
+#ifndef SSD1306_BATCH_H
+#define SSD1306_BATCH_H
+
+/*
+ * Binary batch protocol for /dev/my_ssd1306_device.
+ *
+ * A write() whose first byte is SSD1306_BATCH_MAGIC carries any number of
+ * packed records instead of a single text command:
+ *
+ *     opcode, x, y, len, payload[len]
+ *
+ * The whole batch is drawn into the driver's shadow GDDRAM and flushed once.
+ * Writes that do not start with the magic byte keep the text protocol
+ * ("clear", "cursor x y" or a string to print).
+ *
+ * This header is shared by the kernel driver and the user-space library.
+ */
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+#define SSD1306_BATCH_MAGIC     0xB5    // First byte of a batch write (never starts a text command)
+#define SSD1306_BATCH_MAX       1024    // Maximum size of one batch write, magic byte included
+#define SSD1306_BATCH_HDR_SIZE  4       // opcode, x, y, len
+#define SSD1306_BATCH_KEEP      0xFF    // x/y value meaning "keep the current cursor"
+
+// Record opcodes
+#define SSD1306_OP_NOP          0x00    // Ignored
+#define SSD1306_OP_CLEAR        0x01    // Clear the whole screen
+#define SSD1306_OP_CURSOR       0x02    // Move the text cursor to column x, line y
+#define SSD1306_OP_TEXT         0x03    // Print payload at (x, y), or at the cursor if x/y are KEEP
+#define SSD1306_OP_BLIT         0x04    // Copy payload bytes to page y starting at column x
+#define SSD1306_OP_CLEAR_PAGE   0x05    // Clear line y
+
+// Header of one batch record, followed by len payload bytes
+struct ssd1306_batch_rec {
+    uint8_t opcode;
+    uint8_t x;
+    uint8_t y;
+    uint8_t len;
+};
+
+#endif
@@ -2,9 +2,6 @@
 #include "oled_i2c_ssd1306.h"
 #include "snake.h"
 
-int fd_ssd, fd_button;  // File descriptors for the SSD1306 OLED display and button device
-char kernel_data[2];    // Buffer to store kernel data
-
 // Function to clear the terminal screen
 void clrscr() {
     system("clear");  // Call system command to clear the terminal screen
@@ -13,17 +10,20 @@ void clrscr() {
 
 int main() {
     int c;  // Variable to store keypress input
+    Snake_Game game;  // Display, buttons and state of this session
+    int fd_ssd, fd_button;  // File descriptors for the SSD1306 OLED display and button device
 
     fd_ssd = OLED_OpenDevFile();  // Open the device file for the SSD1306 OLED display
 
     fd_button = Button_OpenDevFile();  // Open the device file for the button input
+    Snake_InitGame(&game, fd_ssd, fd_button);
     clrscr();  // Clear the terminal screen
 
     OLED_Clear(fd_ssd);  // Clear the OLED display
 
     do {
         // Load and start the Snake game
-        Snake_LoadGame(fd_ssd, fd_button, kernel_data, sizeof(kernel_data));
+        Snake_LoadGame(&game);
 
         OLED_Clear(fd_ssd);  // Clear the OLED display after the game finishes
 
@@ -35,7 +35,7 @@ int main() {
         OLED_Display(fd_ssd, "ENTER. YES  Other. NO");  // Display options "ENTER. YES Other. NO"
 
         // Wait for button press and get the key code
-        c = Button_WaitForAnyKey(fd_button, kernel_data, sizeof(kernel_data));
+        c = Snake_WaitForKey(&game);
 
         // If ENTER (code 5) is pressed, play the game again
         if (c == 5) {
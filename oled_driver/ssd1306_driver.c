@@ -1,21 +1,41 @@
 #include "ssd1306_lib.h"
+#include "ssd1306_trace.h"
 
-/* Probe & remove functions for the I2C driver */
+/* Probe & remove functions for the I2C driver: probe lost its id argument in 6.3, remove returns void since 6.1 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+static int ssd1306_probe(struct i2c_client *client);
+#else
 static int ssd1306_probe(struct i2c_client *client, const struct i2c_device_id *id);
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+static void ssd1306_remove(struct i2c_client *client);
+#else
 static int ssd1306_remove(struct i2c_client *client);
+#endif
 
 /* Initialization and cleanup functions for the kernel module */
 static int __init ssd1306_init(void);
 static void __exit ssd1306_exit(void);
 
-/* File operation functions (open, release, write) */
+/* File operation functions (open, release, write, poll, fsync) */
 static int ssd1306_open(struct inode *inode, struct file *file);
 static int ssd1306_release(struct inode *inode, struct file *file);
 static ssize_t ssd1306_write(struct file *filp, const char *user_buf, size_t size, loff_t *offset);
+static unsigned int ssd1306_poll(struct file *file, poll_table *wait);
+static int ssd1306_fsync(struct file *file, loff_t start, loff_t end, int datasync);
+
+/* Frame worker draining the queued commands */
+static void ssd1306_frame_work(struct work_struct *work);
+
+/* Frees the module once it is removed and no longer open */
+static void ssd1306_free(struct ssd1306_i2c_module *module);
 
 /* Global structure to hold SSD1306 module information */
 struct ssd1306_i2c_module *ssd1306_device;
 
+/* Orders open() and release() against remove, which may run while files are still open */
+static DEFINE_MUTEX(ssd1306_open_lock);
+
 /* Structure to represent the character device */
 typedef struct {
     dev_t dev_num;              // Device number (Major and Minor)
@@ -24,19 +44,66 @@ typedef struct {
     int size;                    // Buffer size
 } ssd1306_dev;
 
-char kernel_buff[50];            // Kernel buffer for temporary storage
+char kernel_buff[SSD1306_BATCH_MAX + 1];  // Kernel buffer for one write, NUL-terminated
 ssd1306_dev ssd1306_dev_instance; // Global instance of the device
 
+/* Rate at which queued commands are drawn and sent to the panel */
+static unsigned int frame_rate_hz = 50;
+module_param(frame_rate_hz, uint, 0444);
+MODULE_PARM_DESC(frame_rate_hz, "Rate at which queued writes are flushed to the panel in Hz (default 50)");
+
+/* Cumulative counters under /sys/bus/i2c/devices/<bus>-003c/, so the effect of batching can be measured */
+#define SSD1306_COUNTER_ATTR(name, fmt)                                                         \
+static ssize_t name##_show(struct device *dev, struct device_attribute *attr, char *buf)       \
+{                                                                                               \
+    struct ssd1306_i2c_module *module = i2c_get_clientdata(to_i2c_client(dev));                \
+    return sprintf(buf, fmt "\n", module->name);                                               \
+}                                                                                               \
+static DEVICE_ATTR_RO(name)
+
+SSD1306_COUNTER_ATTR(i2c_transactions, "%lu");
+SSD1306_COUNTER_ATTR(i2c_bytes, "%lu");
+SSD1306_COUNTER_ATTR(i2c_errors, "%lu");
+SSD1306_COUNTER_ATTR(i2c_time_ns, "%llu");
+SSD1306_COUNTER_ATTR(addr_cmds_skipped, "%lu");
+SSD1306_COUNTER_ATTR(writes, "%lu");
+SSD1306_COUNTER_ATTR(write_bytes, "%lu");
+SSD1306_COUNTER_ATTR(frames, "%lu");
+
+static struct attribute *ssd1306_attrs[] = {
+    &dev_attr_i2c_transactions.attr,
+    &dev_attr_i2c_bytes.attr,
+    &dev_attr_i2c_errors.attr,
+    &dev_attr_i2c_time_ns.attr,
+    &dev_attr_addr_cmds_skipped.attr,
+    &dev_attr_writes.attr,
+    &dev_attr_write_bytes.attr,
+    &dev_attr_frames.attr,
+    NULL,
+};
+
+static const struct attribute_group ssd1306_attr_group = {
+    .attrs = ssd1306_attrs,
+};
+
 /* Device Tree matching table */
 static const struct of_device_id ssd1306_of_match[] = {
     { .compatible = "ssd1306_oled" },
     {}
 };
 
+/* I2C device ID table, for boards without a Device Tree node (e.g. the i2c_virt test adapter) */
+static const struct i2c_device_id ssd1306_id[] = {
+    { "ssd1306", 0 },
+    {}
+};
+MODULE_DEVICE_TABLE(i2c, ssd1306_id);
+
 /* I2C driver structure */
 static struct i2c_driver ssd1306_driver = {
     .probe = ssd1306_probe,      // Probe function
     .remove = ssd1306_remove,    // Remove function
+    .id_table = ssd1306_id,      // Name matching table
     .driver = {
         .name = "ssd1306",       // Driver name
         .of_match_table = ssd1306_of_match, // Device Tree matching table
@@ -49,10 +116,16 @@ static struct file_operations ssd1306_fops = {
     .write      = ssd1306_write, // Write function for writing data to the device
     .open       = ssd1306_open,  // Open function for opening the device file
     .release    = ssd1306_release, // Release function for closing the device file
+    .poll       = ssd1306_poll,  // Poll function reporting queue space (POLLOUT)
+    .fsync      = ssd1306_fsync, // Fsync function waiting until queued writes reach the panel
 };
 
 /* Probe function - Called when the I2C device is detected */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+static int ssd1306_probe(struct i2c_client *client)
+#else
 static int ssd1306_probe(struct i2c_client *client, const struct i2c_device_id *id)
+#endif
 {
     pr_info("ssd1306: Probe started\n");
 
@@ -68,6 +141,32 @@ static int ssd1306_probe(struct i2c_client *client, const struct i2c_device_id *
     ssd1306_device->line_num = 0;
     ssd1306_device->cursor_position = 0;
     ssd1306_device->font_size = SSD1306_DEF_FONT_SIZE;
+    ssd1306_device->i2c_transactions = 0;
+    ssd1306_device->i2c_bytes = 0;
+    ssd1306_device->i2c_errors = 0;
+    ssd1306_device->i2c_time_ns = 0;
+    ssd1306_device->writes = 0;
+    ssd1306_device->write_bytes = 0;
+    ssd1306_device->frames = 0;
+    ssd1306_device->addr_valid = false;
+    ssd1306_device->addr_cmds_skipped = 0;
+    ssd1306_device->info = NULL;
+    ssd1306_device->removing = false;
+    ssd1306_device->open_files = 0;
+    mutex_init(&ssd1306_device->lock);
+    i2c_set_clientdata(client, ssd1306_device);
+
+    /* Initialize the asynchronous write path */
+    if (kfifo_alloc(&ssd1306_device->cmd_fifo, SSD1306_QUEUE_SIZE, GFP_KERNEL)) {
+        pr_err("ssd1306: Command queue allocation failed\n");
+        kfree(ssd1306_device);
+        ssd1306_device = NULL;
+        return -ENOMEM;
+    }
+    mutex_init(&ssd1306_device->fifo_lock);
+    init_waitqueue_head(&ssd1306_device->write_wait);
+    INIT_DELAYED_WORK(&ssd1306_device->frame_work, ssd1306_frame_work);
+    ssd1306_device->frame_jiffies = max(HZ / max(frame_rate_hz, 1U), 1U);
 
     /* Initialize the display and print a message */
     ssd1306_display_init(ssd1306_device);
@@ -75,79 +174,333 @@ static int ssd1306_probe(struct i2c_client *client, const struct i2c_device_id *
     ssd1306_print_string(ssd1306_device, "This is Snake Game");
     ssd1306_set_cursor(ssd1306_device, 4, 2);
     ssd1306_print_string(ssd1306_device, "Enjoy this moment !");
+    ssd1306_flush(ssd1306_device);
+
+    /* Export the bus traffic counters under /sys/bus/i2c/devices/<bus>-003c/ */
+    if (sysfs_create_group(&client->dev.kobj, &ssd1306_attr_group)) {
+        pr_warn("ssd1306: Failed to create sysfs counters\n");
+    }
+
+    /* With fb_enable=1, hand the panel to a /dev/fbN device; its clients overwrite character device output */
+    if (ssd1306_fb_register(ssd1306_device)) {
+        pr_warn("ssd1306: Continuing without framebuffer device\n");
+    }
     pr_info("ssd1306: Probe completed\n");
 
     return 0;
 }
 
 /* Remove function - Called when the I2C device is removed */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+static void ssd1306_remove(struct i2c_client *client)
+#else
 static int ssd1306_remove(struct i2c_client *client)
+#endif
 {
     pr_info("ssd1306: Remove started\n");
 
+    ssd1306_fb_unregister(ssd1306_device);
+    sysfs_remove_group(&client->dev.kobj, &ssd1306_attr_group);
+
+    /* Refuse new writes and wake blocked writers; after this nothing can queue or schedule a frame */
+    mutex_lock(&ssd1306_device->fifo_lock);
+    ssd1306_device->removing = true;
+    mutex_unlock(&ssd1306_device->fifo_lock);
+    wake_up_interruptible(&ssd1306_device->write_wait);
+
+    /* Draw whatever is still queued, then stop the frame worker */
+    flush_delayed_work(&ssd1306_device->frame_work);
+    cancel_delayed_work_sync(&ssd1306_device->frame_work);
+
     /* Clear the display and show a goodbye message */
+    mutex_lock(&ssd1306_device->lock);
     ssd1306_clear_full(ssd1306_device);
     ssd1306_set_cursor(ssd1306_device, 3, 0);
     ssd1306_print_string(ssd1306_device, "Thanks for visiting. Goodbye!");
+    ssd1306_flush(ssd1306_device);
     msleep(1000);
     ssd1306_clear_full(ssd1306_device);
+    ssd1306_flush(ssd1306_device);
     ssd1306_write_command(ssd1306_device, true, 0xAE); // Turn off the display
+    mutex_unlock(&ssd1306_device->lock);
 
-    /* Free the allocated memory */
-    kfree(ssd1306_device);
+    /* Free the allocated memory, or leave that to the release of the last open file */
+    mutex_lock(&ssd1306_open_lock);
+    if (!ssd1306_device->open_files) {
+        ssd1306_free(ssd1306_device);
+    }
+    ssd1306_device = NULL;
+    mutex_unlock(&ssd1306_open_lock);
 
     pr_info("ssd1306: Remove completed\n");
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 1, 0)
     return 0;
+#endif
+}
+
+/* Frees a removed module once no open file refers to it */
+static void ssd1306_free(struct ssd1306_i2c_module *module)
+{
+    kfifo_free(&module->cmd_fifo);
+    kfree(module);
 }
 
 /* Open function - Called when the device file is opened */
 static int ssd1306_open(struct inode *inode, struct file *file)
 {
-    pr_info("ssd1306: Device file opened\n");
+    mutex_lock(&ssd1306_open_lock);
+    if (!ssd1306_device) {
+        mutex_unlock(&ssd1306_open_lock);
+        return -ENODEV;  /* The I2C device has not been probed, or was removed */
+    }
+    ssd1306_device->open_files++;
+    file->private_data = ssd1306_device;  /* Stays valid until release, even across remove */
+    mutex_unlock(&ssd1306_open_lock);
+
+    pr_debug("ssd1306: Device file opened\n");
     return 0;
 }
 
 /* Release function - Called when the device file is closed */
 static int ssd1306_release(struct inode *inode, struct file *file)
 {
-    pr_info("ssd1306: Device file closed\n");
+    struct ssd1306_i2c_module *module = file->private_data;
+
+    mutex_lock(&ssd1306_open_lock);
+    if (!--module->open_files && (module != ssd1306_device)) {
+        ssd1306_free(module);  /* Remove already ran and left the memory to us */
+    }
+    mutex_unlock(&ssd1306_open_lock);
+
+    pr_debug("ssd1306: Device file closed\n");
     return 0;
 }
 
-/* Write function - Called when data is written to the device file */
-static ssize_t ssd1306_write(struct file *filp, const char __user *user_buf, size_t size, loff_t *offset)
+/* Checks that a binary batch write is made of complete records with known opcodes */
+static int ssd1306_check_batch(const uint8_t *buf, size_t size)
 {
-    int ret;
+    const struct ssd1306_batch_rec *rec;
+    size_t pos = 1;  /* Skip the magic byte */
+
+    while (pos < size) {
+        if (pos + SSD1306_BATCH_HDR_SIZE > size) {
+            return -EINVAL;  /* Truncated record header */
+        }
+        rec = (const struct ssd1306_batch_rec *)&buf[pos];
+        pos += SSD1306_BATCH_HDR_SIZE + rec->len;
+        if (pos > size) {
+            return -EINVAL;  /* Truncated payload */
+        }
+        if (rec->opcode > SSD1306_OP_CLEAR_PAGE) {
+            return -EINVAL;  /* Unknown opcode */
+        }
+    }
 
-    /* Copy data from user space to kernel space */
-    ret = copy_from_user(kernel_buff, user_buf, size);
-    if (ret) {
-        pr_err("%s - copy_from_user failed\n", __func__);
-        return -EFAULT;
+    return 0;
+}
+
+/* Runs the records of a checked binary batch against the shadow GDDRAM */
+static void ssd1306_run_batch(struct ssd1306_i2c_module *module, const uint8_t *buf, size_t size)
+{
+    const struct ssd1306_batch_rec *rec;
+    const uint8_t *payload;
+    size_t pos = 1;  /* Skip the magic byte */
+    int i;
+
+    while (pos + SSD1306_BATCH_HDR_SIZE <= size) {
+        rec = (const struct ssd1306_batch_rec *)&buf[pos];
+        payload = &buf[pos + SSD1306_BATCH_HDR_SIZE];
+        pos += SSD1306_BATCH_HDR_SIZE + rec->len;
+
+        switch (rec->opcode) {
+        case SSD1306_OP_CLEAR:
+            ssd1306_clear_full(module);
+            break;
+        case SSD1306_OP_CURSOR:
+            ssd1306_set_cursor(module, rec->y, rec->x);
+            break;
+        case SSD1306_OP_TEXT:
+            if ((rec->x != SSD1306_BATCH_KEEP) && (rec->y != SSD1306_BATCH_KEEP)) {
+                ssd1306_set_cursor(module, rec->y, rec->x);
+            }
+            for (i = 0; i < rec->len; i++) {
+                ssd1306_print_char(module, payload[i]);
+            }
+            break;
+        case SSD1306_OP_BLIT:
+            for (i = 0; (i < rec->len) && (rec->x + i < SSD1306_MAX_SEG); i++) {
+                ssd1306_draw_byte(module, rec->y, rec->x + i, payload[i]);
+            }
+            break;
+        case SSD1306_OP_CLEAR_PAGE:
+            if (rec->y <= SSD1306_MAX_LINE) {
+                ssd1306_clear_page(module, rec->y);
+            }
+            break;
+        default:
+            break;  /* SSD1306_OP_NOP */
+        }
+    }
+}
+
+/* Kind of a write() command, for the ssd1306_write tracepoint; same tests as ssd1306_run_command() */
+static u8 ssd1306_command_kind(const char *cmd)
+{
+    if ((uint8_t)cmd[0] == SSD1306_BATCH_MAGIC) {
+        return SSD1306_WRITE_BATCH;
+    }
+    if (!strncmp("clear", cmd, 5)) {
+        return SSD1306_WRITE_CLEAR;
     }
+    if (!strncmp("cursor", cmd, 6)) {
+        return SSD1306_WRITE_CURSOR;
+    }
+    return SSD1306_WRITE_TEXT;
+}
 
+/* Draws one queued write() command (NUL-terminated) into the shadow GDDRAM */
+static void ssd1306_run_command(struct ssd1306_i2c_module *module, char *cmd, size_t size)
+{
+    /* Binary batch: many records drawn with a single flush */
+    if ((uint8_t)cmd[0] == SSD1306_BATCH_MAGIC) {
+        ssd1306_run_batch(module, (const uint8_t *)cmd, size);
+    }
     /* Check if the command is to clear the screen */
-    if (!strncmp("clear", kernel_buff, 5)) {
-        ssd1306_clear_full(ssd1306_device);
+    else if (!strncmp("clear", cmd, 5)) {
+        ssd1306_clear_full(module);
     }
     /* Check if the command is to set the cursor position */
-    else if (!strncmp("cursor", kernel_buff, 6)) {
+    else if (!strncmp("cursor", cmd, 6)) {
         uint8_t x, y;
         char temp[8];
-        sscanf(kernel_buff, "%s %hhu %hhu", temp, &x, &y);
-        ssd1306_set_cursor(ssd1306_device, y, x);
+        sscanf(cmd, "%7s %hhu %hhu", temp, &x, &y);
+        ssd1306_set_cursor(module, y, x);
     }
     /* Otherwise, print the string to the screen */
     else {
-        ssd1306_print_string(ssd1306_device, kernel_buff);
+        ssd1306_print_string(module, cmd);
+    }
+}
+
+/*
+ * Frame worker - runs once per frame while commands are queued.
+ * Every command queued since the last frame is drawn into the shadow GDDRAM
+ * first, so overlapping updates collapse into their final state, and a
+ * single flush then sends the columns that really changed.
+ */
+static void ssd1306_frame_work(struct work_struct *work)
+{
+    struct ssd1306_i2c_module *module = container_of(to_delayed_work(work), struct ssd1306_i2c_module, frame_work);
+    unsigned int budget = kfifo_len(&module->cmd_fifo);  /* Don't chase writers that keep queueing */
+    unsigned int len, commands = 0;
+    unsigned long xfers, bytes;
+    u64 start = ktime_get_ns();
+
+    mutex_lock(&module->lock);
+    xfers = module->i2c_transactions;
+    bytes = module->i2c_bytes;
+    while (budget && !kfifo_is_empty(&module->cmd_fifo)) {
+        len = kfifo_out(&module->cmd_fifo, module->frame_buff, SSD1306_BATCH_MAX);
+        module->frame_buff[len] = '\0';
+        ssd1306_run_command(module, module->frame_buff, len);
+        budget -= min(budget, len + 2);  /* 2-byte record header */
+        commands++;
+    }
+    ssd1306_flush(module);
+    module->frames++;
+    trace_ssd1306_frame(commands, module->i2c_transactions - xfers, module->i2c_bytes - bytes,
+                        ktime_get_ns() - start);
+    mutex_unlock(&module->lock);
+
+    /* Queue space was freed and the panel is up to date: wake writers, pollers and fsync */
+    wake_up_interruptible(&module->write_wait);
+}
+
+/* Write function - Called when data is written to the device file; queues the command and returns */
+static ssize_t ssd1306_write(struct file *filp, const char __user *user_buf, size_t size, loff_t *offset)
+{
+    struct ssd1306_i2c_module *module = filp->private_data;
+    int ret;
+
+    if (size == 0) {
+        return 0;
+    }
+    if (size > SSD1306_BATCH_MAX) {
+        pr_err("%s - write of %zu bytes exceeds %d\n", __func__, size, SSD1306_BATCH_MAX);
+        return -EINVAL;
+    }
+
+    /* kernel_buff and the producer side of the queue are shared by all writers */
+    mutex_lock(&module->fifo_lock);
+
+    /* Wait for room in the queue, or report backpressure to non-blocking writers */
+    while (!module->removing && (kfifo_avail(&module->cmd_fifo) < size)) {
+        mutex_unlock(&module->fifo_lock);
+        if (filp->f_flags & O_NONBLOCK) {
+            return -EAGAIN;
+        }
+        if (wait_event_interruptible(module->write_wait,
+                                     READ_ONCE(module->removing) || (kfifo_avail(&module->cmd_fifo) >= size))) {
+            return -ERESTARTSYS;
+        }
+        mutex_lock(&module->fifo_lock);
     }
+    if (module->removing) {
+        mutex_unlock(&module->fifo_lock);
+        return -ENODEV;  /* The I2C device is being removed */
+    }
+
+    /* Copy data from user space to kernel space */
+    ret = copy_from_user(kernel_buff, user_buf, size);
+    if (ret) {
+        mutex_unlock(&module->fifo_lock);
+        pr_err("%s - copy_from_user failed\n", __func__);
+        return -EFAULT;
+    }
+
+    /* Reject malformed batches now; the worker can no longer report errors */
+    if (((uint8_t)kernel_buff[0] == SSD1306_BATCH_MAGIC) && ssd1306_check_batch((const uint8_t *)kernel_buff, size)) {
+        mutex_unlock(&module->fifo_lock);
+        pr_err("%s - malformed batch\n", __func__);
+        return -EINVAL;
+    }
+
+    kfifo_in(&module->cmd_fifo, kernel_buff, size);
+    module->writes++;
+    module->write_bytes += size;
+    trace_ssd1306_write(ssd1306_command_kind(kernel_buff), size, kfifo_len(&module->cmd_fifo));
 
-    /* Clear the kernel buffer */
-    memset(kernel_buff, 0, sizeof(kernel_buff));
+    /* Start a frame unless one is already pending; under fifo_lock so remove cannot cancel it first */
+    schedule_delayed_work(&module->frame_work, module->frame_jiffies);
+    mutex_unlock(&module->fifo_lock);
 
     return size;
 }
 
+/* Poll function - POLLOUT while a maximum-size command still fits in the queue */
+static unsigned int ssd1306_poll(struct file *file, poll_table *wait)
+{
+    struct ssd1306_i2c_module *module = file->private_data;
+    unsigned int reval_mask = 0;
+
+    poll_wait(file, &module->write_wait, wait);
+
+    if (READ_ONCE(module->removing))
+        return POLLERR;  /* Writes fail with -ENODEV from now on */
+    if (kfifo_avail(&module->cmd_fifo) >= SSD1306_BATCH_MAX)
+        reval_mask |= POLLOUT | POLLWRNORM;  /* Room for another write */
+    return reval_mask;
+}
+
+/* Fsync function - Returns once every command queued so far has been sent to the panel */
+static int ssd1306_fsync(struct file *file, loff_t start, loff_t end, int datasync)
+{
+    struct ssd1306_i2c_module *module = file->private_data;
+
+    flush_delayed_work(&module->frame_work);
+    return 0;
+}
+
 /* Initialization function - Called when the module is loaded */
 static int __init ssd1306_init(void)
 {
@@ -159,8 +512,12 @@ static int __init ssd1306_init(void)
 
     pr_info("ssd1306: Initializing - Major: %d, Minor: %d\n", MAJOR(ssd1306_dev_instance.dev_num), MINOR(ssd1306_dev_instance.dev_num));
 
-    /* Create a device class */
+    /* Create a device class; class_create() lost its module argument in 6.4 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 4, 0)
+    ssd1306_dev_instance.ssd1306_class = class_create("ssd1306_class");
+#else
     ssd1306_dev_instance.ssd1306_class = class_create(THIS_MODULE, "ssd1306_class");
+#endif
     if (IS_ERR(ssd1306_dev_instance.ssd1306_class)) {
         pr_err("ssd1306: Failed to create class\n");
         goto unregister_dev_num;
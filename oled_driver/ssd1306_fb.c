@@ -0,0 +1,237 @@
+#include "ssd1306_lib.h"
+
+/*
+ * Framebuffer (fbdev) front end for the SSD1306.
+ *
+ * User space mmaps a 128x64 1bpp buffer (/dev/fbN) and draws into it without
+ * any syscalls. fb_deferred_io collects the page faults and, once per refresh
+ * interval, converts the buffer into the page-packed shadow GDDRAM. The shadow
+ * only marks columns whose bytes changed, so the flush sends just what the
+ * user actually touched.
+ *
+ * Each pass converts the whole buffer, so a framebuffer client (fbcon
+ * included) overwrites whatever the character device drew. The device is
+ * therefore only registered with fb_enable=1, when the panel belongs to it.
+ */
+
+#if IS_ENABLED(CONFIG_FB_DEFERRED_IO)
+
+#define SSD1306_FB_WIDTH   SSD1306_MAX_SEG
+#define SSD1306_FB_HEIGHT  (SSD1306_MAX_PAGE * 8)
+#define SSD1306_FB_LINE    (SSD1306_FB_WIDTH / 8)   // Bytes per framebuffer row
+#define SSD1306_FB_SIZE    (SSD1306_FB_LINE * SSD1306_FB_HEIGHT)
+
+/* Register /dev/fbN; off by default so fbcon and fb clients can't draw over the game */
+static bool fb_enable;
+module_param(fb_enable, bool, 0444);
+MODULE_PARM_DESC(fb_enable, "Register a framebuffer device that takes over the panel (default 0)");
+
+/* Refresh interval of the deferred I/O worker */
+static unsigned int fb_refresh_hz = 20;
+module_param(fb_refresh_hz, uint, 0444);
+MODULE_PARM_DESC(fb_refresh_hz, "Framebuffer refresh rate in Hz (default 20)");
+
+static const struct fb_fix_screeninfo ssd1306_fb_fix = {
+    .id          = "ssd1306fb",
+    .type        = FB_TYPE_PACKED_PIXELS,
+    .visual      = FB_VISUAL_MONO10,
+    .xpanstep    = 0,
+    .ypanstep    = 0,
+    .ywrapstep   = 0,
+    .line_length = SSD1306_FB_LINE,
+    .accel       = FB_ACCEL_NONE,
+};
+
+static const struct fb_var_screeninfo ssd1306_fb_var = {
+    .xres           = SSD1306_FB_WIDTH,
+    .yres           = SSD1306_FB_HEIGHT,
+    .xres_virtual   = SSD1306_FB_WIDTH,
+    .yres_virtual   = SSD1306_FB_HEIGHT,
+    .bits_per_pixel = 1,
+    .red            = { .length = 1 },
+    .green          = { .length = 1 },
+    .blue           = { .length = 1 },
+};
+
+/* Converts the row-major framebuffer into page-packed columns and flushes the changes */
+static void ssd1306_fb_update(struct fb_info *info)
+{
+    struct ssd1306_i2c_module *module = info->par;
+    const u8 *vmem = (const u8 *)info->screen_base;
+    int page, col, row;
+    u8 data;
+
+    mutex_lock(&module->lock);
+    for (page = 0; page < SSD1306_MAX_PAGE; page++) {
+        for (col = 0; col < SSD1306_FB_WIDTH; col++) {
+            data = 0;
+            for (row = 0; row < 8; row++) {
+                u8 byte = vmem[(page * 8 + row) * SSD1306_FB_LINE + col / 8];
+                data |= ((byte >> (col % 8)) & 1) << row;
+            }
+            ssd1306_draw_byte(module, page, col, data);
+        }
+    }
+    ssd1306_flush(module);
+    mutex_unlock(&module->lock);
+}
+
+/*
+ * Deferred I/O callback. The whole framebuffer fits in one memory page, so
+ * the page list carries no extra information: the shadow GDDRAM diff decides
+ * which columns go over the bus.
+ */
+static void ssd1306_fb_deferred_io(struct fb_info *info, struct list_head *pagelist)
+{
+    ssd1306_fb_update(info);
+}
+
+/* Drawing through write()/fbcon does not fault on the mmap, so kick the worker by hand */
+static void ssd1306_fb_schedule(struct fb_info *info)
+{
+    schedule_delayed_work(&info->deferred_work, info->fbdefio->delay);
+}
+
+static ssize_t ssd1306_fb_write(struct fb_info *info, const char __user *buf, size_t count, loff_t *ppos)
+{
+    ssize_t ret = fb_sys_write(info, buf, count, ppos);
+
+    if (ret > 0) {
+        ssd1306_fb_schedule(info);
+    }
+    return ret;
+}
+
+static void ssd1306_fb_fillrect(struct fb_info *info, const struct fb_fillrect *rect)
+{
+    sys_fillrect(info, rect);
+    ssd1306_fb_schedule(info);
+}
+
+static void ssd1306_fb_copyarea(struct fb_info *info, const struct fb_copyarea *area)
+{
+    sys_copyarea(info, area);
+    ssd1306_fb_schedule(info);
+}
+
+static void ssd1306_fb_imageblit(struct fb_info *info, const struct fb_image *image)
+{
+    sys_imageblit(info, image);
+    ssd1306_fb_schedule(info);
+}
+
+static struct fb_ops ssd1306_fb_ops = {
+    .owner        = THIS_MODULE,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 18, 0)
+    .fb_mmap      = fb_deferred_io_mmap,  // No longer implied by fbdefio on newer kernels
+#endif
+    .fb_read      = fb_sys_read,
+    .fb_write     = ssd1306_fb_write,
+    .fb_fillrect  = ssd1306_fb_fillrect,
+    .fb_copyarea  = ssd1306_fb_copyarea,
+    .fb_imageblit = ssd1306_fb_imageblit,
+};
+
+// Registers the framebuffer device on top of an initialised SSD1306 module
+int ssd1306_fb_register(struct ssd1306_i2c_module *module)
+{
+    struct device *dev = &module->client->dev;
+    struct fb_deferred_io *defio;
+    struct fb_info *info;
+    void *vmem;
+    int ret;
+
+    module->info = NULL;
+    if (!fb_enable) {
+        return 0;  /* The character device owns the panel */
+    }
+
+    info = framebuffer_alloc(0, dev);
+    if (!info) {
+        return -ENOMEM;
+    }
+
+    vmem = (void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, get_order(SSD1306_FB_SIZE));
+    if (!vmem) {
+        ret = -ENOMEM;
+        goto release_fb;
+    }
+
+    defio = devm_kzalloc(dev, sizeof(*defio), GFP_KERNEL);
+    if (!defio) {
+        ret = -ENOMEM;
+        goto free_vmem;
+    }
+    defio->delay = HZ / max(fb_refresh_hz, 1U);
+    defio->deferred_io = ssd1306_fb_deferred_io;
+
+    info->fbops = &ssd1306_fb_ops;
+    info->fix = ssd1306_fb_fix;
+    info->var = ssd1306_fb_var;
+    info->fbdefio = defio;
+    info->par = module;
+    info->screen_base = (u8 __force __iomem *)vmem;
+    info->fix.smem_start = __pa(vmem);
+    info->fix.smem_len = SSD1306_FB_SIZE;
+    info->flags = FBINFO_VIRTFB;  // System memory; FBINFO_FLAG_DEFAULT (0) was removed in 6.6
+
+    /* fb_deferred_io_init() allocates its page tracking and can fail since 5.19 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 19, 0)
+    ret = fb_deferred_io_init(info);
+    if (ret) {
+        pr_err("ssd1306: Failed to set up deferred I/O\n");
+        goto free_vmem;
+    }
+#else
+    fb_deferred_io_init(info);
+#endif
+
+    ret = register_framebuffer(info);
+    if (ret) {
+        pr_err("ssd1306: Failed to register framebuffer\n");
+        goto cleanup_defio;
+    }
+
+    module->info = info;
+    pr_info("ssd1306: fb%d registered, refresh %u Hz\n", info->node, fb_refresh_hz);
+    return 0;
+
+cleanup_defio:
+    fb_deferred_io_cleanup(info);
+free_vmem:
+    free_pages((unsigned long)vmem, get_order(SSD1306_FB_SIZE));
+release_fb:
+    framebuffer_release(info);
+    return ret;
+}
+
+// Unregisters the framebuffer device and frees its buffer
+void ssd1306_fb_unregister(struct ssd1306_i2c_module *module)
+{
+    struct fb_info *info = module->info;
+
+    if (!info) {
+        return;
+    }
+
+    unregister_framebuffer(info);
+    fb_deferred_io_cleanup(info);
+    free_pages((unsigned long)info->screen_base, get_order(SSD1306_FB_SIZE));
+    framebuffer_release(info);
+    module->info = NULL;
+}
+
+#else /* !CONFIG_FB_DEFERRED_IO */
+
+int ssd1306_fb_register(struct ssd1306_i2c_module *module)
+{
+    pr_info("ssd1306: CONFIG_FB_DEFERRED_IO is off, no framebuffer device\n");
+    module->info = NULL;
+    return 0;
+}
+
+void ssd1306_fb_unregister(struct ssd1306_i2c_module *module)
+{
+}
+
+#endif
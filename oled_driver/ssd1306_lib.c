@@ -1,5 +1,8 @@
 #include "ssd1306_lib.h"
 
+#define CREATE_TRACE_POINTS
+#include "ssd1306_trace.h"       // Tracepoints, instantiated in this file
+
 // Font table for characters, each character is 5x8 pixels
 const unsigned char ssd1306_font[][SSD1306_DEF_FONT_SIZE] = {
     // Each character is represented by 5 bytes
@@ -100,42 +103,159 @@ const unsigned char ssd1306_font[][SSD1306_DEF_FONT_SIZE] = {
     {0x00, 0x06, 0x09, 0x09, 0x06}    // ~ (Degrees)
 };
 
-// Sends data over I2C
+// Sends data over I2C and accounts for the transfer
 int ssd1306_i2c_send(struct ssd1306_i2c_module *module, char *buff, int len)
 {
-    return i2c_master_send(module->client, buff, len);
+    u64 start = ktime_get_ns(), duration;
+    int ret = i2c_master_send(module->client, buff, len);
+
+    duration = ktime_get_ns() - start;
+    module->i2c_transactions++;
+    module->i2c_bytes += len;
+    module->i2c_time_ns += duration;
+    if (ret < 0) {
+        module->i2c_errors++;
+    }
+    trace_ssd1306_i2c_send(buff[0], len, duration, ret);
+    return ret;
+}
+
+// Follows the panel's horizontal-mode auto-increment over n data bytes
+static void ssd1306_advance_pointer(struct ssd1306_i2c_module *module, int n)
+{
+    int width = SSD1306_MAX_SEG - module->win_col_start;
+    int height = SSD1306_MAX_PAGE - module->win_page_start;
+    int pos = module->ptr_col - module->win_col_start + n;
+    int page = module->ptr_page - module->win_page_start + pos / width;
+
+    module->ptr_col = module->win_col_start + pos % width;
+    module->ptr_page = module->win_page_start + page % height;
+}
+
+// Writes a run of commands or data bytes, one I2C transfer per SSD1306_BURST_MAX bytes
+int ssd1306_write_burst(struct ssd1306_i2c_module *module, bool check, const uint8_t *data, int len)
+{
+    char buff[SSD1306_BURST_MAX + 1];  // Control byte followed by the payload
+    int chunk, ret;
+
+    while (len > 0) {
+        chunk = min(len, SSD1306_BURST_MAX);
+
+        // If check == true, send command byte (0x00), otherwise send data byte (0x40)
+        buff[0] = check ? 0x00 : 0x40;
+        memcpy(&buff[1], data, chunk);
+
+        ret = ssd1306_i2c_send(module, buff, chunk + 1);
+        if (ret < 0) {
+            module->addr_valid = false;  // Unknown how much the panel received
+            return ret;
+        }
+        if (!check) {
+            ssd1306_advance_pointer(module, chunk);
+        }
+
+        data += chunk;
+        len -= chunk;
+    }
+    return 0;
 }
 
-// Writes a command or data to SSD1306
+// Writes a single command or data byte to SSD1306
 void ssd1306_write_command(struct ssd1306_i2c_module *module, bool check, char data)
 {
-    char buff[2];  // Buffer to hold the data to be sent
+    uint8_t byte = data;
+
+    ssd1306_write_burst(module, check, &byte, 1);
+}
+
+// Points the panel at (page, column), sending only the address commands that change something
+static void ssd1306_set_window(struct ssd1306_i2c_module *module, uint8_t page, uint8_t column)
+{
+    uint8_t cmds[6];
+    int n = 0;
+
+    if (!module->addr_valid || (module->ptr_col != column)) {
+        cmds[n++] = 0x21;                   // Command to set column address
+        cmds[n++] = column;                 // Starting column address
+        cmds[n++] = SSD1306_MAX_SEG - 1;    // Ending column address
+        module->win_col_start = column;
+        module->ptr_col = column;
+    } else {
+        module->addr_cmds_skipped++;        // Auto-increment already reached this column
+    }
 
-    // If check == true, send command byte (0x00), otherwise send data byte (0x40)
-    if (check) {
-        buff[0] = 0x00;  // Control byte for command
+    if (!module->addr_valid || (module->ptr_page != page)) {
+        cmds[n++] = 0x22;                   // Command to set page address
+        cmds[n++] = page;                   // Starting page address
+        cmds[n++] = SSD1306_MAX_LINE;       // Ending page address (max line)
+        module->win_page_start = page;
+        module->ptr_page = page;
     } else {
-        buff[0] = 0x40;  // Control byte for data
+        module->addr_cmds_skipped++;        // Auto-increment already reached this page
     }
 
-    buff[1] = data;  // The data or command to be sent
-    ssd1306_i2c_send(module, buff, 2);  // Send via I2C
+    if (n) {
+        module->addr_valid = true;
+        ssd1306_write_burst(module, true, cmds, n);  // Remaining commands in one transfer
+    }
 }
 
-// Sets the cursor position on the screen
+// Stores one page column in the shadow GDDRAM and marks it dirty only if it changed
+void ssd1306_draw_byte(struct ssd1306_i2c_module *module, uint8_t page, uint8_t column, uint8_t data)
+{
+    if ((page > SSD1306_MAX_LINE) || (column >= SSD1306_MAX_SEG)) {
+        return;
+    }
+    if (module->gddram[page][column] == data) {
+        return;  // Panel already shows this byte
+    }
+
+    module->gddram[page][column] = data;
+    __set_bit(column, module->dirty[page]);
+}
+
+// Marks every column dirty, used when the panel contents are unknown (power-up)
+void ssd1306_invalidate(struct ssd1306_i2c_module *module)
+{
+    int i;
+    for (i = 0; i < SSD1306_MAX_PAGE; i++) {
+        bitmap_fill(module->dirty[i], SSD1306_MAX_SEG);
+    }
+}
+
+// Sends the runs of changed columns of each page to the panel
+void ssd1306_flush(struct ssd1306_i2c_module *module)
+{
+    int page, start, end, next;
+
+    for (page = 0; page < SSD1306_MAX_PAGE; page++) {
+        start = find_first_bit(module->dirty[page], SSD1306_MAX_SEG);
+
+        while (start < SSD1306_MAX_SEG) {
+            end = find_next_zero_bit(module->dirty[page], SSD1306_MAX_SEG, start);
+
+            // Bridge short clean gaps: resending a few bytes is cheaper than a new window
+            next = find_next_bit(module->dirty[page], SSD1306_MAX_SEG, end);
+            while ((next < SSD1306_MAX_SEG) && (next - end <= SSD1306_RUN_GAP)) {
+                end = find_next_zero_bit(module->dirty[page], SSD1306_MAX_SEG, next);
+                next = find_next_bit(module->dirty[page], SSD1306_MAX_SEG, end);
+            }
+
+            ssd1306_set_window(module, page, start);
+            ssd1306_write_burst(module, false, &module->gddram[page][start], end - start);
+            start = next;
+        }
+
+        bitmap_zero(module->dirty[page], SSD1306_MAX_SEG);
+    }
+}
+
+// Sets the text cursor position; nothing is sent until the next flush
 void ssd1306_set_cursor(struct ssd1306_i2c_module *module, uint8_t line_num, uint8_t cursor_position)
 {
     if ((line_num <= SSD1306_MAX_LINE) && (cursor_position < SSD1306_MAX_SEG)) {
         module->line_num = line_num;  // Update the line number
         module->cursor_position = cursor_position;  // Update the cursor position
-
-        // Send commands to set the cursor position
-        ssd1306_write_command(module, true, 0x21);  // Command to set column address
-        ssd1306_write_command(module, true, cursor_position);  // Starting column address
-        ssd1306_write_command(module, true, SSD1306_MAX_SEG - 1);  // Ending column address
-        ssd1306_write_command(module, true, 0x22);  // Command to set page address
-        ssd1306_write_command(module, true, line_num);  // Starting page address (line number)
-        ssd1306_write_command(module, true, SSD1306_MAX_LINE);  // Ending page address (max line)
     }
 }
 
@@ -155,12 +275,17 @@ int convert(char c)
     return ((int)c - 32);  // Convert character to font index
 }
 
-// Prints a single character to the screen
+// Draws a single character into the shadow GDDRAM at the text cursor
 void ssd1306_print_char(struct ssd1306_i2c_module *module, unsigned char c)
 {
     uint8_t temp = 0;
     int pos_line = convert(c);  // Get the character's font index
 
+    // Characters outside the font table are drawn as a space
+    if ((c < ' ') || (c > '~')) {
+        pos_line = 0;
+    }
+
     // If not enough space on the current line, move to the next line
     if ((module->cursor_position + module->font_size) >= SSD1306_MAX_SEG || c == '\n') {
         ssd1306_goto_next_line(module);
@@ -169,16 +294,17 @@ void ssd1306_print_char(struct ssd1306_i2c_module *module, unsigned char c)
     // Draw the character
     if (c != '\n') {
         for (temp = 0; temp < module->font_size; temp++) {
-            ssd1306_write_command(module, false, ssd1306_font[pos_line][temp]);  // Send each column of the character
+            // Store each column of the character
+            ssd1306_draw_byte(module, module->line_num, module->cursor_position, ssd1306_font[pos_line][temp]);
             module->cursor_position++;  // Move cursor to the right
         }
 
-        ssd1306_write_command(module, false, 0x00);  // Add space between characters
+        ssd1306_draw_byte(module, module->line_num, module->cursor_position, 0x00);  // Add space between characters
         module->cursor_position++;
     }
 }
 
-// Prints a string to the screen
+// Draws a string into the shadow GDDRAM
 void ssd1306_print_string(struct ssd1306_i2c_module *module, unsigned char *str)
 {
     while (*str) {
@@ -189,21 +315,26 @@ void ssd1306_print_string(struct ssd1306_i2c_module *module, unsigned char *str)
 // Sets the brightness of the SSD1306 screen
 void ssd1306_set_brightness(struct ssd1306_i2c_module *module, uint8_t brightness)
 {
-    ssd1306_write_command(module, true, 0x81);  // Command to set brightness
-    ssd1306_write_command(module, true, brightness);  // Send brightness level (0-255)
+    uint8_t cmds[] = {
+        0x81,           // Command to set brightness
+        brightness,     // Brightness level (0-255)
+    };
+
+    ssd1306_write_burst(module, true, cmds, sizeof(cmds));
 }
 
-// Clears a specific page (line) on the screen
+// Clears a specific page (line) in the shadow GDDRAM; only lit columns become dirty
 void ssd1306_clear_page(struct ssd1306_i2c_module *module, uint8_t line)
 {
-    ssd1306_set_cursor(module, line, 0);  // Set cursor to the start of the line
     int i;
+
+    ssd1306_set_cursor(module, line, 0);  // Set cursor to the start of the line
     for (i = 0; i < SSD1306_MAX_SEG; i++) {
-        ssd1306_write_command(module, false, 0x00);  // Write 0 to clear the line
+        ssd1306_draw_byte(module, line, i, 0x00);  // Write 0 to clear the line
     }
 }
 
-// Clears the entire screen
+// Clears the entire screen in the shadow GDDRAM
 void ssd1306_clear_full(struct ssd1306_i2c_module *module)
 {
     int i;
@@ -215,18 +346,29 @@ void ssd1306_clear_full(struct ssd1306_i2c_module *module)
 // Initializes the SSD1306 display
 int ssd1306_display_init(struct ssd1306_i2c_module *module)
 {
+    uint8_t init_cmds[] = {
+        0xAE,   // Turn off the display
+        0xA8,   // Set multiplex ratio
+        0x3F,   // 64 COM lines
+        0x20,   // Set memory addressing mode
+        0x00,   // Horizontal, so flushed runs follow the column window
+        // Additional initialization commands go here...
+        0xAF,   // Turn on the display
+    };
+
     msleep(100);  // Wait for 100ms to allow the display to power on
 
-    // Send initialization commands to the display
-    ssd1306_write_command(module, true, 0xAE);  // Turn off the display
-    ssd1306_write_command(module, true, 0xA8);  // Set multiplex ratio
-    ssd1306_write_command(module, true, 0x3F);  // 64 COM lines
-    // Additional initialization commands go here...
+    // Send initialization commands to the display in one transfer
+    ssd1306_write_burst(module, true, init_cmds, sizeof(init_cmds));
 
-    ssd1306_write_command(module, true, 0xAF);  // Turn on the display
+    // GDDRAM holds garbage after power-up: start from a blank shadow and resend everything
+    memset(module->gddram, 0, sizeof(module->gddram));
+    ssd1306_invalidate(module);
+    module->addr_valid = false;  // Addressing window unknown until the first flush sets it
 
     // Display welcome message
     ssd1306_set_cursor(module, 0, 0);
     ssd1306_print_string(module, "Hello TungNHS\n");
+    ssd1306_flush(module);
     return 0;
 }
@@ -13,11 +13,25 @@
 #include <linux/uaccess.h>       // For user-space and kernel-space data transfer
 #include <linux/errno.h>        
 #include <linux/delay.h>         // For introducing delays in kernel
+#include <linux/bitmap.h>        // For the dirty-column bitmaps
+#include <linux/mutex.h>         // For serialising access to the panel
+#include <linux/fb.h>            // For the framebuffer (fbdev) front end
+#include <linux/kfifo.h>         // For the queue of pending write() commands
+#include <linux/workqueue.h>     // For the frame worker
+#include <linux/poll.h>          // For poll operations
+#include <linux/ktime.h>         // For timing I2C transfers and frames
+#include <linux/version.h>       // For the kernel API differences between versions
+
+#include "../inc/ssd1306_batch.h"  // Binary batch protocol shared with user space
 
 // SSD1306 screen dimensions
 #define SSD1306_MAX_SEG 128       // Maximum number of columns on the screen
 #define SSD1306_MAX_LINE 7        // Maximum number of lines on the screen
 #define SSD1306_DEF_FONT_SIZE 5   // Default font size
+#define SSD1306_MAX_PAGE (SSD1306_MAX_LINE + 1)  // Number of 8-pixel pages in GDDRAM
+#define SSD1306_BURST_MAX SSD1306_MAX_SEG  // Maximum payload bytes behind one control byte
+#define SSD1306_QUEUE_SIZE 8192   // Bytes of queued write() commands (power of two)
+#define SSD1306_RUN_GAP 6         // Clean columns worth resending to avoid a new addressing window
 
 // Structure representing the SSD1306 I2C module
 struct ssd1306_i2c_module {
@@ -25,6 +39,39 @@ struct ssd1306_i2c_module {
     uint8_t line_num;             // Current line number
     uint8_t cursor_position;      // Current cursor position
     uint8_t font_size;            // Font size in use
+    struct mutex lock;            // Serialises drawing and flushing between the cdev and fbdev
+    struct fb_info *info;         // Framebuffer device, NULL if not registered
+
+    // Asynchronous write path: write() queues commands, the frame worker draws and flushes them
+    struct kfifo_rec_ptr_2 cmd_fifo;          // One record per write() call
+    struct mutex fifo_lock;                   // Serialises producers of cmd_fifo
+    struct delayed_work frame_work;           // Drains cmd_fifo once per frame
+    unsigned long frame_jiffies;              // Frame period
+    wait_queue_head_t write_wait;             // Writers and pollers waiting for queue space
+    bool removing;                            // Set under fifo_lock by remove; write() then fails with -ENODEV
+    unsigned int open_files;                  // Open file descriptors, under ssd1306_open_lock
+    char frame_buff[SSD1306_BATCH_MAX + 1];   // Command being executed by the worker
+
+    // Shadow copy of the panel's display RAM (GDDRAM), one byte per page column.
+    // Drawing only touches this copy; ssd1306_flush() sends the changed ranges.
+    uint8_t gddram[SSD1306_MAX_PAGE][SSD1306_MAX_SEG];
+    unsigned long dirty[SSD1306_MAX_PAGE][BITS_TO_LONGS(SSD1306_MAX_SEG)];  // Changed columns per page
+
+    // Panel addressing state, mirrored so repeated window commands can be skipped
+    bool addr_valid;              // False until the panel state below is known
+    uint8_t win_col_start;        // Column window start (end is always SSD1306_MAX_SEG - 1)
+    uint8_t win_page_start;       // Page window start (end is always SSD1306_MAX_LINE)
+    uint8_t ptr_col;              // Column the next data byte lands in
+    uint8_t ptr_page;             // Page the next data byte lands in
+    unsigned long addr_cmds_skipped;  // Column/page address commands not sent because nothing changed
+
+    unsigned long i2c_transactions;  // Number of I2C transfers sent to the panel
+    unsigned long i2c_bytes;         // Number of bytes sent, control bytes included
+    unsigned long i2c_errors;        // Transfers that failed
+    u64 i2c_time_ns;                 // Time spent in I2C transfers
+    unsigned long writes;            // write() calls queued
+    unsigned long write_bytes;       // Bytes queued by write()
+    unsigned long frames;            // Runs of the frame worker
 };
 
 // Function to send data over I2C
@@ -33,6 +80,18 @@ int ssd1306_i2c_send(struct ssd1306_i2c_module *module, char *buff, int len);
 // Function to write command or data to SSD1306
 void ssd1306_write_command(struct ssd1306_i2c_module *module, bool check, char data);
 
+// Function to write a run of command or data bytes behind a single control byte
+int ssd1306_write_burst(struct ssd1306_i2c_module *module, bool check, const uint8_t *data, int len);
+
+// Function to store one page column in the shadow GDDRAM and mark it dirty if it changed
+void ssd1306_draw_byte(struct ssd1306_i2c_module *module, uint8_t page, uint8_t column, uint8_t data);
+
+// Function to mark the whole shadow GDDRAM dirty (panel contents unknown)
+void ssd1306_invalidate(struct ssd1306_i2c_module *module);
+
+// Function to send the dirty ranges of the shadow GDDRAM to the panel
+void ssd1306_flush(struct ssd1306_i2c_module *module);
+
 // Function to set the cursor position on the SSD1306 screen
 void ssd1306_set_cursor(struct ssd1306_i2c_module *module, uint8_t line_num, uint8_t cursor_position);
 
@@ -60,4 +119,10 @@ void ssd1306_clear_full(struct ssd1306_i2c_module *module);
 // Function to initialize the SSD1306 display
 int ssd1306_display_init(struct ssd1306_i2c_module *module);
 
+// Function to register the framebuffer device (fbdev with deferred I/O)
+int ssd1306_fb_register(struct ssd1306_i2c_module *module);
+
+// Function to unregister the framebuffer device
+void ssd1306_fb_unregister(struct ssd1306_i2c_module *module);
+
 #endif
@@ -0,0 +1,96 @@
+/* Tracepoints of the SSD1306 driver, under /sys/kernel/tracing/events/ssd1306/ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ssd1306
+
+#if !defined(_SSD1306_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _SSD1306_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* Kinds of write() command, see ssd1306_run_command() */
+#define SSD1306_WRITE_TEXT      0
+#define SSD1306_WRITE_CLEAR     1
+#define SSD1306_WRITE_CURSOR    2
+#define SSD1306_WRITE_BATCH     3
+
+/* One I2C transfer to the panel: control byte 0x00 is commands, 0x40 is GDDRAM data */
+TRACE_EVENT(ssd1306_i2c_send,
+    TP_PROTO(u8 control, int len, u64 duration_ns, int ret),
+    TP_ARGS(control, len, duration_ns, ret),
+
+    TP_STRUCT__entry(
+        __field(u8, control)
+        __field(int, len)
+        __field(u64, duration_ns)
+        __field(int, ret)
+    ),
+
+    TP_fast_assign(
+        __entry->control = control;
+        __entry->len = len;
+        __entry->duration_ns = duration_ns;
+        __entry->ret = ret;
+    ),
+
+    TP_printk("%s len=%d duration_ns=%llu ret=%d",
+              __entry->control == 0x40 ? "data" : "cmd", __entry->len,
+              __entry->duration_ns, __entry->ret)
+);
+
+/* One write() queued for the frame worker */
+TRACE_EVENT(ssd1306_write,
+    TP_PROTO(u8 kind, size_t size, unsigned int queued),
+    TP_ARGS(kind, size, queued),
+
+    TP_STRUCT__entry(
+        __field(u8, kind)
+        __field(size_t, size)
+        __field(unsigned int, queued)
+    ),
+
+    TP_fast_assign(
+        __entry->kind = kind;
+        __entry->size = size;
+        __entry->queued = queued;
+    ),
+
+    TP_printk("%s size=%zu queued=%u",
+              __print_symbolic(__entry->kind,
+                               { SSD1306_WRITE_TEXT, "text" },
+                               { SSD1306_WRITE_CLEAR, "clear" },
+                               { SSD1306_WRITE_CURSOR, "cursor" },
+                               { SSD1306_WRITE_BATCH, "batch" }),
+              __entry->size, __entry->queued)
+);
+
+/* One run of the frame worker: commands drawn and the bus traffic of the flush */
+TRACE_EVENT(ssd1306_frame,
+    TP_PROTO(unsigned int commands, unsigned long xfers, unsigned long bytes, u64 duration_ns),
+    TP_ARGS(commands, xfers, bytes, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, commands)
+        __field(unsigned long, xfers)
+        __field(unsigned long, bytes)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->commands = commands;
+        __entry->xfers = xfers;
+        __entry->bytes = bytes;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("commands=%u xfers=%lu bytes=%lu duration_ns=%llu",
+              __entry->commands, __entry->xfers, __entry->bytes, __entry->duration_ns)
+);
+
+#endif /* _SSD1306_TRACE_H */
+
+/* This part must be outside the include guard */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE ssd1306_trace
+#include <trace/define_trace.h>
@@ -1,7 +1,24 @@
 #include "button.h"
+#include <pthread.h>
+
+static const Button_Backend *button_backend;  // Selected input backend, NULL until first use
+static const char *button_backend_arg;        // Text after "name:" in the backend spec
+
+// One scripted press: wait delay_ms after the previous one, then press and release id
+struct button_step {
+    long delay_ms;
+    uint8_t id;
+};
+
+// A parsed input script, fed into a pipe by its own thread
+struct button_script {
+    int fd;                     // Write end of the pipe
+    size_t count;               // Number of steps
+    struct button_step *steps;
+};
 
 // Open the button device file for reading
-int Button_OpenDevFile() {
+static int Button_DevOpen(const char *arg) {
     int fd = open(SSD1306_BUTTON_FILE, O_RDONLY | O_NONBLOCK);  // Open the button device file in read-only and non-blocking mode
     if (fd == -1) {
         perror("Failed to open device file");  // Print error if opening fails
@@ -11,8 +28,156 @@ int Button_OpenDevFile() {
     return fd;  // Return the file descriptor
 }
 
-// Read button input from the device
-int Button_Read(int fdt, char *buff, size_t size) {
+// Convert a script token (1-5 or up/left/right/down/enter) to a button id, 0 if unknown
+static int Button_ScriptKey(const char *key) {
+    static const char *const names[] = { "up", "left", "right", "down", "enter" };
+    int i;
+
+    if (key[0] >= '1' && key[0] <= '5' && key[1] == '\0') {
+        return key[0] - '0';
+    }
+    for (i = 0; i < 5; i++) {
+        if (!strcasecmp(key, names[i])) {
+            return i + 1;  // Same order as UP..ENTER
+        }
+    }
+    return 0;
+}
+
+// Current CLOCK_MONOTONIC time in nanoseconds, the clock the driver stamps events with
+static int64_t Button_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Replay the script into the pipe with the same records and timing the driver would produce
+static void *Button_ScriptFeeder(void *arg) {
+    struct button_script *script = arg;
+    struct btn_event event;
+    struct timespec at;
+    size_t i;
+
+    clock_gettime(CLOCK_MONOTONIC, &at);
+    for (i = 0; i < script->count; i++) {
+        at.tv_sec += script->steps[i].delay_ms / 1000;
+        at.tv_nsec += (script->steps[i].delay_ms % 1000) * 1000000L;
+        if (at.tv_nsec >= 1000000000L) {
+            at.tv_sec++;
+            at.tv_nsec -= 1000000000L;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) == EINTR);
+
+        memset(&event, 0, sizeof(event));
+        event.id = script->steps[i].id;
+        event.pressed = 1;
+        event.ts_ns = Button_Now();
+        write(script->fd, &event, sizeof(event));
+        event.pressed = 0;
+        event.ts_ns = Button_Now();
+        write(script->fd, &event, sizeof(event));
+    }
+
+    // Nothing more will be pressed: the reader sees end of file once the pipe is drained
+    fprintf(stderr, "Input script finished\n");
+    close(script->fd);
+    free(script->steps);
+    free(script);
+    return NULL;
+}
+
+// Open a scripted input: "<delay_ms> <button>" per line, '#' starts a comment
+static int Button_ScriptOpen(const char *path) {
+    struct button_script *script;
+    struct button_step *steps;
+    pthread_t thread;
+    char line[128], key[16];
+    long delay;
+    int pipefd[2], id;
+    FILE *file;
+
+    file = path ? fopen(path, "r") : NULL;
+    script = calloc(1, sizeof(*script));
+    if (!file || !script) {
+        perror("Failed to open input script");
+        exit(EXIT_FAILURE);
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%ld %15s", &delay, key) != 2 || line[0] == '#') {
+            continue;  // Blank line or comment
+        }
+        id = Button_ScriptKey(key);
+        if (!id || delay < 0) {
+            fprintf(stderr, "Bad input script line: %s", line);
+            exit(EXIT_FAILURE);
+        }
+        steps = realloc(script->steps, (script->count + 1) * sizeof(*steps));
+        if (!steps) {
+            perror("Failed to load input script");
+            exit(EXIT_FAILURE);
+        }
+        script->steps = steps;
+        script->steps[script->count].delay_ms = delay;
+        script->steps[script->count].id = id;
+        script->count++;
+    }
+    fclose(file);
+
+    // The read end behaves like the device: non-blocking, pollable, one record per read
+    if (pipe(pipefd) == -1 || fcntl(pipefd[0], F_SETFL, O_NONBLOCK) == -1) {
+        perror("Failed to create input pipe");
+        exit(EXIT_FAILURE);
+    }
+    script->fd = pipefd[1];
+
+    if (pthread_create(&thread, NULL, Button_ScriptFeeder, script)) {
+        fprintf(stderr, "Failed to start input script\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_detach(thread);
+
+    return pipefd[0];
+}
+
+static const Button_Backend button_backends[] = {
+    { "dev",    Button_DevOpen },
+    { "script", Button_ScriptOpen },
+};
+
+// Select the input backend from a spec such as "dev" or "script:moves.txt"
+int Button_SetBackend(const char *spec) {
+    const char *colon = strchr(spec, ':');
+    size_t len = colon ? (size_t)(colon - spec) : strlen(spec);
+    size_t i;
+
+    for (i = 0; i < sizeof(button_backends) / sizeof(button_backends[0]); i++) {
+        if (strlen(button_backends[i].name) == len && !strncmp(spec, button_backends[i].name, len)) {
+            button_backend = &button_backends[i];
+            button_backend_arg = colon ? colon + 1 : NULL;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Open the button device file (or the selected input backend) for reading
+int Button_OpenDevFile() {
+    const char *spec;
+
+    if (!button_backend) {
+        spec = getenv("SNAKE_INPUT");
+        if (!spec || Button_SetBackend(spec)) {
+            button_backend = &button_backends[0];
+        }
+    }
+
+    return button_backend->open(button_backend_arg);
+}
+
+// Read the next button event from the device without blocking
+int Button_ReadEvent(int fdt, struct btn_event *event) {
     fd_set fds;
     struct timeval timeout;
     int re;
@@ -23,21 +188,45 @@ int Button_Read(int fdt, char *buff, size_t size) {
     timeout.tv_sec = 0;  // Set timeout to 0 seconds
     timeout.tv_usec = 0;  // Set timeout to 0 microseconds
 
-    // Use select to check if the button file descriptor is ready for reading
+    // Use select to check if the button file descriptor is ready for reading.
+    // Reading a single record leaves the fd readable while more events are queued.
     if (select(fdt + 1, &fds, NULL, NULL, &timeout) > 0) {
-        re = read(fdt, buff, size - 1);  // Read from the device
+        re = read(fdt, event, sizeof(*event));  // Read one event record from the device
+        re = (re == sizeof(*event)) ? 1 : (re == 0) ? 0 : -1;  // 0: the writer closed the input
     } else {
         re = -1;  // Set return value to -1 if no data is available
     }
 
-    return re;  // Return the number of bytes read or -1
+    return re;  // Return 1 if an event was read, 0 at the end of the input or -1
+}
+
+// Read button input from the device; only presses are reported, as an ASCII digit in buff
+int Button_Read(int fdt, char *buff, size_t size) {
+    struct btn_event event;
+    int re = Button_ReadEvent(fdt, &event);
+
+    if (re == 0) {
+        return BUTTON_EOF;  // No more events will come
+    }
+    if (re < 0) {
+        return -1;  // No event available
+    }
+    if (!event.pressed || size < 2) {
+        return 0;  // Releases don't count as key presses
+    }
+
+    buff[0] = '0' + event.id;  // Same format as the driver's legacy single-byte read
+    buff[1] = '\0';
+    return 1;  // Return the number of bytes stored
 }
 
 // Check if any button is pressed
 int Button_CheckAnyPress(int fd, char *buff, size_t size) {
     int ret = Button_Read(fd, buff, size);  // Read button state
 
-    if (ret <= 0) {
+    if (ret == BUTTON_EOF) {
+        return BUTTON_EOF;  // The input has ended
+    } else if (ret <= 0) {
         return 0;  // No button pressed
     } else {
         return 1;  // Button pressed
@@ -51,21 +240,37 @@ int Button_Press(char *buff) {
 
 // Wait until any button is pressed and return its value
 int Button_WaitForAnyKey(int fd, char *buff, size_t size) {
+    struct pollfd pfd;
     int pressed;
 
-    // Loop until a button is pressed
-    while (!Button_CheckAnyPress(fd, buff, size));
+    pfd.fd = fd;
+    pfd.events = POLLIN;
 
+    // Sleep in poll() until the driver reports a press, instead of spinning on read
+    do {
+        if (poll(&pfd, 1, -1) == -1 && errno != EINTR) {
+            perror("poll");
+            return 0;
+        }
+    } while (!(pressed = Button_CheckAnyPress(fd, buff, size)));
+
+    if (pressed == BUTTON_EOF) {
+        return BUTTON_EOF;  // Nobody is left to press a key
+    }
     pressed = Button_Press(buff);  // Get the pressed button value
     return pressed;  // Return the button value
 }
 
 // Check keypress and return the direction based on the button pressed
 int Button_KeysPressedToDirection(int fd, char *buff, size_t size, int direction) {
-    int pressed;
-    
+    int pressed = Button_CheckAnyPress(fd, buff, size);
+
+    if (pressed == BUTTON_EOF) {
+        return BUTTON_EOF;  // The input has ended
+    }
+
     // If a button is pressed
-    if (Button_CheckAnyPress(fd, buff, size)) {
+    if (pressed) {
         pressed = Button_Press(buff);  // Get the pressed button value
 
         // Change direction based on the button pressed, ensuring no reverse direction
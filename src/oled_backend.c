@@ -0,0 +1,327 @@
+#include "oled_i2c_ssd1306.h"
+#include "oled_backend.h"
+#include "oled_font.h"
+
+#define SSD1306_DEV_FILE    "/dev/my_ssd1306_device"  // Device file path for SSD1306 OLED
+#define TERM_ROWS           (OLED_PAGES * 4)          // Terminal rows, two pixel rows per character
+
+static const OLED_Backend *oled_backend;  // Selected backend, NULL until first use
+static unsigned long oled_writes;         // Calls of OLED_Write()
+
+// State of the in-memory panel, interpreted the same way as the kernel driver
+static struct {
+    unsigned char gddram[OLED_PAGES][OLED_WIDTH];  // Page-packed pixels, bit 0 is the top row
+    int line;                                      // Text cursor page
+    int col;                                       // Text cursor column
+} oled_mem;
+
+// Cells currently shown on the terminal: bit 0 upper pixel, bit 1 lower pixel
+static unsigned char term_shown[TERM_ROWS][OLED_WIDTH];
+
+/*
+ * Real device backend
+ */
+static int Dev_Open(void) {
+    int fd = open(SSD1306_DEV_FILE, O_WRONLY);  // Open the device file in write-only mode
+
+    if (fd == -1) {  // If the file cannot be opened
+        printf("Open /dev/my_ssd1306 failed. Please check the dev folder\n");
+        exit(EXIT_FAILURE);  // Exit the program if the file cannot be opened
+    }
+    return fd;  // Return the file descriptor if successful
+}
+
+static ssize_t Dev_Write(int fd, const void *buf, size_t len) {
+    return write(fd, buf, len);
+}
+
+static int Dev_Sync(int fd) {
+    return fsync(fd);  // The driver queues writes; fsync waits for the frame worker
+}
+
+/*
+ * In-memory backend: same text and batch semantics as ssd1306_driver.c
+ */
+static void Mem_SetCursor(int line, int col) {
+    if (line >= 0 && line < OLED_PAGES && col >= 0 && col < OLED_WIDTH) {
+        oled_mem.line = line;
+        oled_mem.col = col;
+    }
+}
+
+static void Mem_DrawByte(int page, int col, unsigned char data) {
+    if (page >= 0 && page < OLED_PAGES && col >= 0 && col < OLED_WIDTH) {
+        oled_mem.gddram[page][col] = data;
+    }
+}
+
+static void Mem_PrintChar(unsigned char c) {
+    int glyph = (c < OLED_FONT_FIRST || c > OLED_FONT_LAST) ? 0 : c - OLED_FONT_FIRST;
+    int i;
+
+    // If not enough space on the current line, move to the next line
+    if (oled_mem.col + OLED_FONT_WIDTH >= OLED_WIDTH || c == '\n') {
+        Mem_SetCursor((oled_mem.line + 1) % OLED_PAGES, 0);
+    }
+
+    if (c != '\n') {
+        for (i = 0; i < OLED_FONT_WIDTH; i++) {
+            Mem_DrawByte(oled_mem.line, oled_mem.col++, OLED_Font[glyph][i]);
+        }
+        Mem_DrawByte(oled_mem.line, oled_mem.col++, 0x00);  // Space between characters
+    }
+}
+
+// Same checks as ssd1306_check_batch(): complete records with known opcodes
+static int Mem_CheckBatch(const unsigned char *buf, size_t len) {
+    size_t pos = 1;  // Skip the magic byte
+
+    while (pos < len) {
+        if (pos + SSD1306_BATCH_HDR_SIZE > len) {
+            return -1;  // Truncated record header
+        }
+        if (buf[pos] > SSD1306_OP_CLEAR_PAGE) {
+            return -1;  // Unknown opcode
+        }
+        pos += SSD1306_BATCH_HDR_SIZE + buf[pos + 3];
+        if (pos > len) {
+            return -1;  // Truncated payload
+        }
+    }
+    return 0;
+}
+
+// Runs a batch already accepted by Mem_CheckBatch()
+static void Mem_RunBatch(const unsigned char *buf, size_t len) {
+    size_t pos = 1;  // Skip the magic byte
+    int i;
+
+    while (pos + SSD1306_BATCH_HDR_SIZE <= len) {
+        const unsigned char *rec = &buf[pos];
+        const unsigned char *payload = &buf[pos + SSD1306_BATCH_HDR_SIZE];
+        int x = rec[1], y = rec[2], n = rec[3];
+
+        pos += SSD1306_BATCH_HDR_SIZE + n;
+
+        switch (rec[0]) {
+        case SSD1306_OP_CLEAR:
+            memset(oled_mem.gddram, 0, sizeof(oled_mem.gddram));
+            break;
+        case SSD1306_OP_CURSOR:
+            Mem_SetCursor(y, x);
+            break;
+        case SSD1306_OP_TEXT:
+            if (x != SSD1306_BATCH_KEEP && y != SSD1306_BATCH_KEEP) {
+                Mem_SetCursor(y, x);
+            }
+            for (i = 0; i < n; i++) {
+                Mem_PrintChar(payload[i]);
+            }
+            break;
+        case SSD1306_OP_BLIT:
+            for (i = 0; i < n; i++) {
+                Mem_DrawByte(y, x + i, payload[i]);
+            }
+            break;
+        case SSD1306_OP_CLEAR_PAGE:
+            if (y < OLED_PAGES) {
+                memset(oled_mem.gddram[y], 0, OLED_WIDTH);
+            }
+            break;
+        }
+    }
+}
+
+static int Mem_Open(void) {
+    memset(&oled_mem, 0, sizeof(oled_mem));
+    return open("/dev/null", O_WRONLY);  // A real fd, so callers can treat it like the device
+}
+
+static ssize_t Mem_Write(int fd, const void *buf, size_t len) {
+    const unsigned char *cmd = buf;
+    char text[SSD1306_BATCH_MAX + 1];
+    unsigned int x, y;
+    size_t i;
+
+    if (len == 0 || len > SSD1306_BATCH_MAX) {
+        errno = EINVAL;
+        return len ? -1 : 0;
+    }
+
+    if (cmd[0] == SSD1306_BATCH_MAGIC) {
+        // The driver rejects a malformed batch as a whole, before drawing any of it
+        if (Mem_CheckBatch(cmd, len)) {
+            errno = EINVAL;
+            return -1;
+        }
+        Mem_RunBatch(cmd, len);
+    } else {
+        memcpy(text, cmd, len);
+        text[len] = '\0';
+
+        if (!strncmp("clear", text, 5)) {
+            memset(oled_mem.gddram, 0, sizeof(oled_mem.gddram));
+        } else if (!strncmp("cursor", text, 6)) {
+            if (sscanf(text, "cursor %u %u", &x, &y) == 2) {
+                Mem_SetCursor(y, x);
+            }
+        } else {
+            for (i = 0; text[i]; i++) {
+                Mem_PrintChar((unsigned char)text[i]);
+            }
+        }
+    }
+    return len;
+}
+
+static int Mem_Sync(int fd) {
+    return 0;  // Writes are applied immediately
+}
+
+/*
+ * Terminal backend: the in-memory panel drawn with half-block characters,
+ * re-emitting only the cells that changed since the previous write.
+ */
+static void Term_Restore(void) {
+    printf("\x1b[%d;1H\x1b[?25h", TERM_ROWS + 1);  // Park below the panel and show the cursor
+    fflush(stdout);
+}
+
+static void Term_Render(void) {
+    static const char *const glyphs[4] = { " ", "▀", "▄", "█" };  // none, upper, lower, both
+    int row, col, y, code;
+    int next_col = -1, next_row = -1;  // Where the terminal cursor already is
+
+    for (row = 0; row < TERM_ROWS; row++) {
+        for (col = 0; col < OLED_WIDTH; col++) {
+            y = row * 2;
+            code = (oled_mem.gddram[y / 8][col] >> (y % 8)) & 1;
+            code |= ((oled_mem.gddram[(y + 1) / 8][col] >> ((y + 1) % 8)) & 1) << 1;
+
+            if (code == term_shown[row][col]) {
+                continue;
+            }
+            if (row != next_row || col != next_col) {
+                printf("\x1b[%d;%dH", row + 1, col + 1);  // Move only when not already there
+            }
+            fputs(glyphs[code], stdout);
+            term_shown[row][col] = code;
+            next_row = row;
+            next_col = col + 1;
+        }
+    }
+    fflush(stdout);
+}
+
+static int Term_Open(void) {
+    memset(term_shown, 0, sizeof(term_shown));
+    printf("\x1b[2J\x1b[?25l");  // Blank screen matches term_shown; hide the cursor
+    fflush(stdout);
+    atexit(Term_Restore);
+    return Mem_Open();
+}
+
+static ssize_t Term_Write(int fd, const void *buf, size_t len) {
+    ssize_t ret = Mem_Write(fd, buf, len);
+
+    Term_Render();
+    return ret;
+}
+
+/*
+ * Null backend: discards the stream, so benchmarks time only its encoding
+ */
+static int Null_Open(void) {
+    return open("/dev/null", O_WRONLY);
+}
+
+static ssize_t Null_Write(int fd, const void *buf, size_t len) {
+    return len;
+}
+
+static int Null_Sync(int fd) {
+    return 0;
+}
+
+static const OLED_Backend oled_backends[] = {
+    { "dev",  Dev_Open,  Dev_Write,  Dev_Sync },
+    { "mem",  Mem_Open,  Mem_Write,  Mem_Sync },
+    { "term", Term_Open, Term_Write, Mem_Sync },
+    { "null", Null_Open, Null_Write, Null_Sync },
+};
+
+/*
+ * Function: OLED_SetBackend
+ * -------------------------
+ * Selects the backend the OLED_* functions talk to.
+ *
+ * name: "dev", "mem", "term" or "null".
+ *
+ * returns: 0 on success, -1 if the name is unknown.
+ */
+int OLED_SetBackend(const char *name) {
+    size_t i;
+
+    for (i = 0; i < sizeof(oled_backends) / sizeof(oled_backends[0]); i++) {
+        if (!strcmp(name, oled_backends[i].name)) {
+            oled_backend = &oled_backends[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Function: OLED_GetBackend
+ * -------------------------
+ * Returns the selected backend. On first use it is taken from the SNAKE_OLED
+ * environment variable, falling back to the real device.
+ */
+const OLED_Backend *OLED_GetBackend(void) {
+    const char *name;
+
+    if (!oled_backend) {
+        name = getenv("SNAKE_OLED");
+        if (!name || OLED_SetBackend(name)) {
+            oled_backend = &oled_backends[0];
+        }
+    }
+    return oled_backend;
+}
+
+/*
+ * Function: OLED_Write
+ * --------------------
+ * Sends one command or batch to the selected backend.
+ */
+ssize_t OLED_Write(int fd, const void *buf, size_t len) {
+    oled_writes++;
+    return OLED_GetBackend()->write(fd, buf, len);
+}
+
+/*
+ * Function: OLED_WriteCount
+ * -------------------------
+ * Returns the number of OLED_Write() calls so far, for the game loop telemetry.
+ */
+unsigned long OLED_WriteCount(void) {
+    return oled_writes;
+}
+
+/*
+ * Function: OLED_Sync
+ * -------------------
+ * Waits until everything written so far is on the display.
+ */
+int OLED_Sync(int fd) {
+    return OLED_GetBackend()->sync(fd);
+}
+
+/*
+ * Function: OLED_MemFrame
+ * -----------------------
+ * Returns the page-packed contents of the in-memory framebuffer.
+ */
+const unsigned char (*OLED_MemFrame(void))[OLED_WIDTH] {
+    return (const unsigned char (*)[OLED_WIDTH])oled_mem.gddram;
+}
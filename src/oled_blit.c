@@ -0,0 +1,98 @@
+#include <string.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "oled_blit.h"
+
+#define ONES    0x0101010101010101ULL  // One bit per byte lane
+
+static const uint8_t blit_zero[OLED_WIDTH];  // Stands in for sprite pages above or below the sprite
+
+// Combine the sprite page starting in this page (shifted down) with the bottom of the page above it
+static inline uint8_t OLED_BlitByte(uint8_t cur, uint8_t above, int shift) {
+    return (uint8_t)(cur << shift) | (uint8_t)(above >> (8 - shift));
+}
+
+/*
+ * Draw n columns of one destination page: cur is the sprite page that starts
+ * in it, above the sprite page whose bottom rows spill into it. Every byte
+ * lane is shifted by the same amount, so 8 or 16 columns go at once.
+ */
+static void OLED_BlitPage(uint8_t *dst, const uint8_t *cur, const uint8_t *above, int n, int shift, int erase) {
+    int i = 0;
+
+#ifdef __ARM_NEON
+    const int8x16_t up = vdupq_n_s8(shift);
+    const int8x16_t down = vdupq_n_s8(shift - 8);  // Negative counts shift right
+
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t bits = vorrq_u8(vshlq_u8(vld1q_u8(cur + i), up), vshlq_u8(vld1q_u8(above + i), down));
+        uint8x16_t d = vld1q_u8(dst + i);
+
+        vst1q_u8(dst + i, erase ? vbicq_u8(d, bits) : vorrq_u8(d, bits));
+    }
+#endif
+
+    // 8 columns per 64-bit word; the masks stop bits crossing into the next byte lane
+    const uint64_t up_mask = ONES * (uint8_t)(0xFF << shift);
+    const uint64_t down_mask = ONES * (uint8_t)(0xFF >> (8 - shift));
+
+    for (; i + 8 <= n; i += 8) {
+        uint64_t c, a, d, bits;
+
+        memcpy(&c, cur + i, 8);
+        memcpy(&a, above + i, 8);
+        memcpy(&d, dst + i, 8);
+        bits = ((c << shift) & up_mask) | ((a >> (8 - shift)) & down_mask);
+        d = erase ? d & ~bits : d | bits;
+        memcpy(dst + i, &d, 8);
+    }
+
+    for (; i < n; i++) {
+        uint8_t bits = OLED_BlitByte(cur[i], above[i], shift);
+
+        dst[i] = erase ? dst[i] & ~bits : dst[i] | bits;
+    }
+}
+
+static void OLED_Blit(OLED_Frame *frame, int x, int y, const OLED_Sprite *sprite, int erase) {
+    int pages = (sprite->h + 7) / 8;
+    int skip = x < 0 ? -x : 0;  // Sprite columns left of the panel
+    int n = sprite->w - skip;
+    int top = y >> 3, shift = y & 7;  // Floor division, also for negative y
+    int page, src;
+    const uint8_t *cur, *above;
+
+    if (x + sprite->w > OLED_WIDTH) {
+        n -= x + sprite->w - OLED_WIDTH;
+    }
+    if (n <= 0) {
+        return;
+    }
+    x += skip;
+
+    // A shifted sprite reaches one page further down
+    for (page = top; page < top + pages + (shift != 0); page++) {
+        if (page < 0 || page >= OLED_PAGES) {
+            continue;
+        }
+        src = page - top;
+        cur = src < pages ? sprite->data + src * sprite->w + skip : blit_zero;
+        above = src > 0 ? sprite->data + (src - 1) * sprite->w + skip : blit_zero;
+
+        OLED_BlitPage(&frame->pix[page][x], cur, above, n, shift, erase);
+        OLED_FrameTouch(frame, page, x, x + n);
+    }
+}
+
+// Turn on the sprite's pixels at (x, y)
+void OLED_FrameBlit(OLED_Frame *frame, int x, int y, const OLED_Sprite *sprite) {
+    OLED_Blit(frame, x, y, sprite, 0);
+}
+
+// Turn off the sprite's pixels at (x, y)
+void OLED_FrameErase(OLED_Frame *frame, int x, int y, const OLED_Sprite *sprite) {
+    OLED_Blit(frame, x, y, sprite, 1);
+}
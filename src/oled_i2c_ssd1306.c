@@ -1,23 +1,18 @@
 #include "oled_i2c_ssd1306.h"
 
-#define SSD1306_DEV_FILE    "/dev/my_ssd1306_device"  // Device file path for SSD1306 OLED
+#include "oled_backend.h"
+#include "oled_font.h"
 
 /*
  * Function: OLED_OpenDevFile
  * --------------------------
- * Opens the device file for the SSD1306 OLED display.
+ * Opens the OLED display through the selected backend (see oled_backend.h).
  *
- * returns: the file descriptor (fd) for the opened device file.
- * If the file cannot be opened, the function prints an error message and exits the program.
+ * returns: the file descriptor (fd) for the opened display.
+ * If the real device file cannot be opened, the function prints an error message and exits the program.
  */
 int OLED_OpenDevFile(){
-    int fd = open(SSD1306_DEV_FILE, O_WRONLY);  // Open the device file in write-only mode
-
-    if (fd == -1) {  // If the file cannot be opened
-        printf("Open /dev/my_ssd1306 failed. Please check the dev folder\n");
-        exit(EXIT_FAILURE);  // Exit the program if the file cannot be opened
-    }
-    return fd;  // Return the file descriptor if successful
+    return OLED_GetBackend()->open();
 }
 
 /*
@@ -29,15 +24,17 @@ int OLED_OpenDevFile(){
  * x: the column position on the OLED display.
  * y: the row (line) position on the OLED display.
  *
- * This function sends the command "cursor x y" to the OLED device to set the cursor at the specified position.
+ * This function sends a single binary cursor record to the OLED device, avoiding
+ * the string formatting of the text "cursor x y" command.
  */
 void OLED_SetCursor(int fd, int x, int y)
 {
-    char str[20];  // Buffer to store the command string
-    sprintf(str, "cursor %d %d", x, y);  // Create the command "cursor x y"
-    
+    unsigned char cmd[1 + SSD1306_BATCH_HDR_SIZE] = {
+        SSD1306_BATCH_MAGIC, SSD1306_OP_CURSOR, (unsigned char)x, (unsigned char)y, 0
+    };
+
     // Write the command to the OLED device file
-    int w = write(fd, str, strlen(str));   
+    int w = OLED_Write(fd, cmd, sizeof(cmd));
     if (w == -1)  // If the write operation fails
     {
         printf("Can not set cursor to LCD\n");  // Print an error message
@@ -55,7 +52,7 @@ void OLED_SetCursor(int fd, int x, int y)
  * This function writes the string to the OLED device, and the string will appear on the screen.
  */
 void OLED_Display(int fd, char *str){
-    int w = write(fd, str, strlen(str));  // Write the string to the OLED device
+    int w = OLED_Write(fd, str, strlen(str));  // Write the string to the OLED device
     if (w == -1)  // If the write operation fails
     {
         printf("Can not write to LCD\n");  // Print an error message
@@ -73,5 +70,398 @@ void OLED_Display(int fd, char *str){
  */
 void OLED_Clear(int fd)
 {
-    write(fd, "clear", 5);  // Send the "clear" command to the OLED device
+    OLED_Write(fd, "clear", 5);  // Send the "clear" command to the OLED device
+}
+
+/*
+ * Function: OLED_BatchBegin
+ * -------------------------
+ * Starts an empty batch of display operations.
+ *
+ * batch: the batch to initialise.
+ * fd: the file descriptor of the opened device file the batch is flushed to.
+ */
+void OLED_BatchBegin(OLED_Batch *batch, int fd)
+{
+    batch->fd = fd;
+    batch->buf[0] = SSD1306_BATCH_MAGIC;
+    batch->len = 1;
+}
+
+/*
+ * Function: OLED_BatchAppend
+ * --------------------------
+ * Appends one record to the batch, flushing first if it would not fit.
+ * Payloads longer than one record allows are split over several records.
+ */
+static void OLED_BatchAppend(OLED_Batch *batch, unsigned char opcode, int x, int y, const unsigned char *payload, size_t len)
+{
+    struct ssd1306_batch_rec rec;
+
+    if (len > UINT8_MAX) {
+        len = UINT8_MAX;
+    }
+    if (batch->len + SSD1306_BATCH_HDR_SIZE + len > SSD1306_BATCH_MAX) {
+        OLED_BatchFlush(batch);
+    }
+
+    rec.opcode = opcode;
+    rec.x = (unsigned char)x;
+    rec.y = (unsigned char)y;
+    rec.len = (unsigned char)len;
+    memcpy(&batch->buf[batch->len], &rec, SSD1306_BATCH_HDR_SIZE);
+    batch->len += SSD1306_BATCH_HDR_SIZE;
+
+    if (len) {
+        memcpy(&batch->buf[batch->len], payload, len);
+        batch->len += len;
+    }
+}
+
+/*
+ * Function: OLED_BatchSetCursor
+ * -----------------------------
+ * Queues a cursor move to column x, line y.
+ */
+void OLED_BatchSetCursor(OLED_Batch *batch, int x, int y)
+{
+    OLED_BatchAppend(batch, SSD1306_OP_CURSOR, x, y, NULL, 0);
+}
+
+/*
+ * Function: OLED_BatchDisplay
+ * ---------------------------
+ * Queues a string to be printed at the cursor position reached by the
+ * previous operations of the batch.
+ */
+void OLED_BatchDisplay(OLED_Batch *batch, const char *str)
+{
+    size_t len = strlen(str);
+
+    do {
+        size_t chunk = len > UINT8_MAX ? UINT8_MAX : len;
+        OLED_BatchAppend(batch, SSD1306_OP_TEXT, SSD1306_BATCH_KEEP, SSD1306_BATCH_KEEP, (const unsigned char *)str, chunk);
+        str += chunk;
+        len -= chunk;
+    } while (len > 0);
+}
+
+/*
+ * Function: OLED_BatchClear
+ * -------------------------
+ * Queues a full screen clear.
+ */
+void OLED_BatchClear(OLED_Batch *batch)
+{
+    OLED_BatchAppend(batch, SSD1306_OP_CLEAR, 0, 0, NULL, 0);
+}
+
+/*
+ * Function: OLED_BatchBlit
+ * ------------------------
+ * Queues raw column bytes for one page (8 pixel rows) of the display.
+ *
+ * x: the first column to write.
+ * page: the page (text line) to write.
+ * data: one byte per column, bit 0 is the top pixel row of the page.
+ * len: the number of columns.
+ */
+void OLED_BatchBlit(OLED_Batch *batch, int x, int page, const unsigned char *data, int len)
+{
+    while (len > 0) {
+        int chunk = len > UINT8_MAX ? UINT8_MAX : len;
+        OLED_BatchAppend(batch, SSD1306_OP_BLIT, x, page, data, chunk);
+        x += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/*
+ * Function: OLED_BatchClearPage
+ * -----------------------------
+ * Queues a clear of one page (text line) of the display.
+ */
+void OLED_BatchClearPage(OLED_Batch *batch, int page)
+{
+    OLED_BatchAppend(batch, SSD1306_OP_CLEAR_PAGE, 0, page, NULL, 0);
+}
+
+/*
+ * Function: OLED_BatchFlush
+ * -------------------------
+ * Sends every queued operation to the OLED device in a single write().
+ *
+ * returns: the result of write(), or 0 if the batch was empty.
+ */
+int OLED_BatchFlush(OLED_Batch *batch)
+{
+    int w = 0;
+
+    if (batch->len > 1) {
+        w = OLED_Write(batch->fd, batch->buf, batch->len);
+        if (w == -1) {
+            printf("Can not write batch to LCD\n");  // Print an error message
+        }
+    }
+
+    batch->len = 1;  // Keep the magic byte for the next operations
+    return w;
+}
+
+/*
+ * Function: OLED_FrameInit
+ * ------------------------
+ * Starts diffing frames against a blank panel.
+ *
+ * frame: the frame to initialise.
+ * fd: the file descriptor of the opened device file, cleared just before.
+ */
+void OLED_FrameInit(OLED_Frame *frame, int fd)
+{
+    frame->fd = fd;
+    frame->known = 1;
+    memset(frame->dirtyFrom, OLED_WIDTH, sizeof(frame->dirtyFrom));
+    memset(frame->dirtyTo, 0, sizeof(frame->dirtyTo));
+    memset(frame->pix, 0, sizeof(frame->pix));
+    memset(frame->shown, 0, sizeof(frame->shown));
+}
+
+/*
+ * Function: OLED_FrameTouch
+ * -------------------------
+ * Widens the range of columns of a page that OLED_FrameEnd() compares.
+ *
+ * page: the page drawn on; pages outside the panel are ignored.
+ * x0, x1: the first column and the column after the last one, clipped to the panel.
+ */
+void OLED_FrameTouch(OLED_Frame *frame, int page, int x0, int x1)
+{
+    if (page < 0 || page >= OLED_PAGES) {
+        return;
+    }
+    x0 = x0 < 0 ? 0 : x0;
+    x1 = x1 > OLED_WIDTH ? OLED_WIDTH : x1;
+    if (x0 >= x1) {
+        return;
+    }
+    if (x0 < frame->dirtyFrom[page]) {
+        frame->dirtyFrom[page] = x0;
+    }
+    if (x1 > frame->dirtyTo[page]) {
+        frame->dirtyTo[page] = x1;
+    }
+}
+
+// Marks every column of every page as drawn
+static void OLED_FrameTouchAll(OLED_Frame *frame)
+{
+    memset(frame->dirtyFrom, 0, sizeof(frame->dirtyFrom));
+    memset(frame->dirtyTo, OLED_WIDTH, sizeof(frame->dirtyTo));
+}
+
+/*
+ * Function: OLED_FrameInvalidate
+ * ------------------------------
+ * Call after drawing on the panel without the frame (text commands, another
+ * batch); the next OLED_FrameEnd() then sends every page.
+ */
+void OLED_FrameInvalidate(OLED_Frame *frame)
+{
+    frame->known = 0;
+    OLED_FrameTouchAll(frame);
+}
+
+/*
+ * Function: OLED_FrameBegin
+ * -------------------------
+ * Starts a new frame with every pixel off. The caller draws the whole
+ * screen; every page is compared and only the difference with the previous
+ * frame is sent. Callers that only change a few cells skip it and draw over
+ * the last frame instead, so only the columns they touch are compared.
+ */
+void OLED_FrameBegin(OLED_Frame *frame)
+{
+    memset(frame->pix, 0, sizeof(frame->pix));
+    OLED_FrameTouchAll(frame);
+}
+
+/*
+ * Function: OLED_FramePixel
+ * -------------------------
+ * Turns one pixel on or off. Pixels outside the panel are ignored.
+ */
+void OLED_FramePixel(OLED_Frame *frame, int x, int y, int on)
+{
+    if (x < 0 || y < 0 || x >= OLED_WIDTH || y >= OLED_PAGES * 8) {
+        return;
+    }
+    if (on) {
+        frame->pix[y / 8][x] |= 1 << (y % 8);
+    } else {
+        frame->pix[y / 8][x] &= ~(1 << (y % 8));
+    }
+    OLED_FrameTouch(frame, y / 8, x, x + 1);
+}
+
+/*
+ * Function: OLED_FrameFill
+ * ------------------------
+ * Turns a rectangle of pixels on or off, one masked byte per column and page.
+ * The rectangle is clipped to the panel.
+ */
+void OLED_FrameFill(OLED_Frame *frame, int x, int y, int w, int h, int on)
+{
+    int x1 = x + w, y1 = y + h;
+    int page, col, top, bottom;
+    unsigned char mask;
+
+    x = x < 0 ? 0 : x;
+    y = y < 0 ? 0 : y;
+    x1 = x1 > OLED_WIDTH ? OLED_WIDTH : x1;
+    y1 = y1 > OLED_PAGES * 8 ? OLED_PAGES * 8 : y1;
+
+    for (page = y / 8; x < x1 && page * 8 < y1; page++) {
+        // Rows of this page inside the rectangle
+        top = y > page * 8 ? y % 8 : 0;
+        bottom = y1 < (page + 1) * 8 ? y1 % 8 : 8;
+        mask = (0xFF << top) & (0xFF >> (8 - bottom));
+
+        OLED_FrameTouch(frame, page, x, x1);
+        for (col = x; col < x1; col++) {
+            if (on) {
+                frame->pix[page][col] |= mask;
+            } else {
+                frame->pix[page][col] &= ~mask;
+            }
+        }
+    }
+}
+
+/*
+ * Function: OLED_FrameText
+ * ------------------------
+ * Draws a string on one text line, each glyph followed by a blank column
+ * like the driver prints it. Text past the right edge is clipped.
+ *
+ * x: the first column.
+ * line: the text line (page), 0 to 7.
+ * str: the string to draw.
+ */
+void OLED_FrameText(OLED_Frame *frame, int x, int line, const char *str)
+{
+    int glyph, i;
+
+    if (line < 0 || line >= OLED_PAGES) {
+        return;
+    }
+
+    OLED_FrameTouch(frame, line, x, x + (int)strlen(str) * (OLED_FONT_WIDTH + 1));
+    for (; *str && x < OLED_WIDTH; str++) {
+        glyph = (*str < OLED_FONT_FIRST || *str > OLED_FONT_LAST) ? 0 : *str - OLED_FONT_FIRST;
+        for (i = 0; i <= OLED_FONT_WIDTH; i++, x++) {
+            if (x >= 0 && x < OLED_WIDTH) {
+                frame->pix[line][x] = i < OLED_FONT_WIDTH ? OLED_Font[glyph][i] : 0x00;
+            }
+        }
+    }
+}
+
+/*
+ * Function: OLED_FrameSprite
+ * --------------------------
+ * ORs an 8 pixel high sprite into the frame at any pixel position. Each
+ * column byte is shifted into the page it starts on and the page below.
+ *
+ * x, y: the top left pixel of the sprite.
+ * cols: one byte per column, bit 0 is the top pixel row.
+ * w: the number of columns.
+ */
+void OLED_FrameSprite(OLED_Frame *frame, int x, int y, const unsigned char *cols, int w)
+{
+    int page = y >> 3, shift = y & 7;
+    int i;
+
+    OLED_FrameTouch(frame, page, x, x + w);
+    if (shift) {
+        OLED_FrameTouch(frame, page + 1, x, x + w);
+    }
+    for (i = 0; i < w; i++, x++) {
+        if (x < 0 || x >= OLED_WIDTH) {
+            continue;
+        }
+        if (page >= 0 && page < OLED_PAGES) {
+            frame->pix[page][x] |= cols[i] << shift;
+        }
+        if (shift && page + 1 >= 0 && page + 1 < OLED_PAGES) {
+            frame->pix[page + 1][x] |= cols[i] >> (8 - shift);
+        }
+    }
+}
+
+/*
+ * Function: OLED_FrameEnd
+ * -----------------------
+ * Compares the drawn columns of the frame with the last one sent and queues
+ * one BLIT record per run of changed columns. Runs separated by no more unchanged columns than
+ * a record header are merged, since resending them is cheaper than a new
+ * record. A page that became blank is cleared with a single record. Nothing
+ * is written when the frame did not change.
+ *
+ * returns: 0 on success, -1 if the last write failed.
+ */
+int OLED_FrameEnd(OLED_Frame *frame)
+{
+    static const unsigned char blank[OLED_WIDTH];
+    OLED_Batch batch;
+    int page, x, from, to, start, end, gap;
+    const unsigned char *pix;
+    unsigned char *shown;
+
+    OLED_BatchBegin(&batch, frame->fd);
+
+    for (page = 0; page < OLED_PAGES; page++) {
+        from = frame->known ? frame->dirtyFrom[page] : 0;
+        to = frame->known ? frame->dirtyTo[page] : OLED_WIDTH;
+        pix = frame->pix[page];
+        shown = frame->shown[page];
+
+        if (from >= to || (frame->known && !memcmp(&pix[from], &shown[from], to - from))) {
+            continue;  // Page not drawn on, or unchanged
+        }
+        if (!memcmp(pix, blank, OLED_WIDTH)) {
+            OLED_BatchClearPage(&batch, page);
+            memcpy(&shown[from], &pix[from], to - from);
+            continue;
+        }
+
+        for (x = from; x < to; ) {
+            if (frame->known && pix[x] == shown[x]) {
+                x++;
+                continue;
+            }
+
+            // Extend the run until more than a header's worth of columns is unchanged
+            start = x;
+            end = x + 1;
+            for (gap = 0, x++; x < to && gap <= SSD1306_BATCH_HDR_SIZE; x++) {
+                if (!frame->known || pix[x] != shown[x]) {
+                    end = x + 1;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+            x = end;
+
+            OLED_BatchBlit(&batch, start, page, &pix[start], end - start);
+        }
+        memcpy(&shown[from], &pix[from], to - from);
+    }
+
+    memset(frame->dirtyFrom, OLED_WIDTH, sizeof(frame->dirtyFrom));
+    memset(frame->dirtyTo, 0, sizeof(frame->dirtyTo));
+    frame->known = 1;
+
+    return OLED_BatchFlush(&batch) == -1 ? -1 : 0;
 }
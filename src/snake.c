@@ -1,6 +1,6 @@
 #include "snake.h"
-
-int fx[26] = {0,5,10,15,20,25,30,35,40,45,50,55,60,65,70,75,80,85,90,95,100,105,110,115,120,125};  // Array of possible x-coordinates for food
+#include "oled_blit.h"
+#include "oled_font.h"  // Glyphs used as board sprites
 
 // Get the game speed (from 1 to 9)
 int Snake_GetGameSpeed() {
@@ -11,246 +11,377 @@ int Snake_GetGameSpeed() {
     return 1;
 }
 
-// Check collision with snake's body
-int Snake_CheckCollisionWithBody(int x, int y, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength, int detect) {
-    int i;
-    for (i = detect; i < snakeLength; i++) {
-        if (x == snakeXY[0][i] && y == snakeXY[1][i]) {
-            return 1;  // Collision detected
-        }
-    }
-    return 0;  // No collision
-}
+#define SNAKE_CELL_PAGES    ((SNAKE_CELL_PY + 7) / 8)  // Pages of one cell sprite
 
-// Generate food at a random position and display it on the screen
-void Snake_GenerateFood(int fd, int foodXY[], int width, int height, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength) {
-    do {
-        srand(time(NULL));
-        int temp = rand() % 27;  // Random column
-        foodXY[0] = fx[temp];    // Assign random x-coordinate
-        srand(time(NULL));
-        foodXY[1] = rand() % 7;  // Random row
-    } while (Snake_CheckCollisionWithBody(foodXY[0], foodXY[1], snakeXY, snakeLength, 0));
-
-    OLED_SetCursor(fd, foodXY[0], foodXY[1]);
-    OLED_Display(fd, "o");  // Display food as 'o'
-}
+// Cell sprites: body, head and food
+enum { SNAKE_SPRITE_BODY, SNAKE_SPRITE_HEAD, SNAKE_SPRITE_FOOD, SNAKE_SPRITES };
 
-// Prepare snake's initial position in the array
-void Snake_PrepareArray(int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength) {
-    int i;
-    int snakeX = snakeXY[0][0];
-    int snakeY = snakeXY[1][0];
+#if SNAKE_CELL_PX == OLED_FONT_WIDTH && SNAKE_CELL_PY == 8
+// Text-sized cells keep the '*', 'O' and 'o' glyphs
+static const OLED_Sprite snake_sprites[SNAKE_SPRITES] = {
+    { OLED_FONT_WIDTH, 8, OLED_Font['*' - OLED_FONT_FIRST] },
+    { OLED_FONT_WIDTH, 8, OLED_Font['O' - OLED_FONT_FIRST] },
+    { OLED_FONT_WIDTH, 8, OLED_Font['o' - OLED_FONT_FIRST] },
+};
 
-    for (i = 1; i <= snakeLength; i++) {
-        snakeXY[0][i] = snakeX - 5 * i;  // Initialize snake's x-positions
-        snakeXY[1][i] = snakeY;          // Keep y-positions same
+static void Snake_InitSprites(void) {
+}
+#else
+static uint8_t snake_sprite_data[SNAKE_SPRITES][SNAKE_CELL_PAGES * SNAKE_CELL_PX];
+static OLED_Sprite snake_sprites[SNAKE_SPRITES];
+
+// Fill the top left w x h pixels of a cell sprite with a pattern for even and odd columns
+static void Snake_MakeSprite(int id, int w, int h, uint8_t even, uint8_t odd) {
+    uint8_t *data = snake_sprite_data[id];
+    int page, col, rows;
+
+    for (page = 0; page < SNAKE_CELL_PAGES; page++) {
+        rows = h - page * 8;  // Rows of the pattern in this page
+        rows = rows < 0 ? 0 : rows > 8 ? 8 : rows;
+        for (col = 0; col < SNAKE_CELL_PX; col++) {
+            data[page * SNAKE_CELL_PX + col] = col < w ? (uint8_t)(0xFF >> (8 - rows)) & (col & 1 ? odd : even) : 0;
+        }
     }
+    snake_sprites[id].w = SNAKE_CELL_PX;
+    snake_sprites[id].h = SNAKE_CELL_PY;
+    snake_sprites[id].data = data;
 }
 
-// Move the snake array based on the direction
-void Snake_MoveArray(int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength, int direction) {
-    int i;
-    for (i = snakeLength - 1; i >= 1; i--) {
-        snakeXY[0][i] = snakeXY[0][i - 1];
-        snakeXY[1][i] = snakeXY[1][i - 1];
-    }
+// Solid segments with a one pixel gap between cells when there is room, a checkered food cell
+static void Snake_InitSprites(void) {
+    int gap = SNAKE_CELL_PX > 2 && SNAKE_CELL_PY > 2;
 
-    // Update the head's position based on direction
-    switch (direction) {
-        case DOWN:
-            snakeXY[1][0]++;
-            break;
-        case RIGHT:
-            snakeXY[0][0] += 5;
-            break;
-        case UP:
-            snakeXY[1][0]--;
-            break;
-        case LEFT:
-            snakeXY[0][0] -= 5;
-            break;
-    }
+    Snake_MakeSprite(SNAKE_SPRITE_BODY, SNAKE_CELL_PX - gap, SNAKE_CELL_PY - gap, 0xFF, 0xFF);
+    Snake_MakeSprite(SNAKE_SPRITE_HEAD, SNAKE_CELL_PX, SNAKE_CELL_PY, 0xFF, 0xFF);
+    Snake_MakeSprite(SNAKE_SPRITE_FOOD, SNAKE_CELL_PX, SNAKE_CELL_PY, 0x55, 0xAA);
 }
+#endif
 
-// Move the snake and update the display
-void Snake_Move(int fd, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength, int direction) {
-    int x = snakeXY[0][snakeLength - 1];
-    int y = snakeXY[1][snakeLength - 1];
+// Draw one board cell
+static void Snake_DrawCell(OLED_Frame *frame, int x, int y, int sprite) {
+    OLED_FrameBlit(frame, x * SNAKE_CELL_PX, y * SNAKE_CELL_PY, &snake_sprites[sprite]);
+}
 
-    // Clear the tail
-    OLED_SetCursor(fd, x, y);
-    OLED_Display(fd, " ");
+// Turn off every pixel of a board cell
+static void Snake_EraseCell(OLED_Frame *frame, int x, int y) {
+    OLED_FrameFill(frame, x * SNAKE_CELL_PX, y * SNAKE_CELL_PY, SNAKE_CELL_PX, SNAKE_CELL_PY, 0);
+}
 
-    // Convert the head to a body part
-    OLED_SetCursor(fd, snakeXY[0][0], snakeXY[1][0]);
-    OLED_Display(fd, "*");
+// Replace whatever a board cell shows with a sprite
+static void Snake_ReplaceCell(OLED_Frame *frame, int x, int y, int sprite) {
+    Snake_EraseCell(frame, x, y);
+    Snake_DrawCell(frame, x, y, sprite);
+}
 
-    // Move the snake
-    Snake_MoveArray(snakeXY, snakeLength, direction);
+// Draw the whole board and the info bar into a new frame and send what changed
+static void Snake_Draw(OLED_Frame *frame, const Snake_State *state) {
+    int i;
 
-    // Update the new head position
-    OLED_SetCursor(fd, snakeXY[0][0], snakeXY[1][0]);
-    OLED_Display(fd, "O");
+    OLED_FrameBegin(frame);
 
-    // Avoid flashing underscore by resetting the cursor
-    OLED_SetCursor(fd, 1, 1);
-}
+    // Food, gone once the snake has won by eating it
+    if (state->status != SNAKE_WON) {
+        Snake_DrawCell(frame, Snake_FoodX(state), Snake_FoodY(state), SNAKE_SPRITE_FOOD);
+    }
 
-// Check if the snake has eaten the food
-int Snake_EatFood(int snakeXY[][SNAKE_ARRAY_SIZE], int foodXY[]) {
-    if (snakeXY[0][0] == foodXY[0] && snakeXY[1][0] == foodXY[1]) {
-        foodXY[0] = 0;
-        foodXY[1] = 0; 
-        return 1;  // Food eaten
+    // Body and head, unless the head left the board
+    for (i = 1; i < state->length; i++) {
+        Snake_DrawCell(frame, Snake_SegmentX(state, i), Snake_SegmentY(state, i), SNAKE_SPRITE_BODY);
     }
-    return 0;  // No food eaten
+    if (state->status != SNAKE_LOST) {
+        Snake_DrawCell(frame, Snake_SegmentX(state, 0), Snake_SegmentY(state, 0), SNAKE_SPRITE_HEAD);
+    }
+
+    Snake_RefreshInfoBar(frame, state->score, state->speed);
+    OLED_FrameEnd(frame);
 }
 
-// Check for collisions with walls or itself
-int Snake_CollisionDetection(int snakeXY[][SNAKE_ARRAY_SIZE], int ScreenWidth, int ScreenHeight, int snakeLength) {
-    // Collision with walls
-    if (snakeXY[0][0] < 0 || snakeXY[1][0] < 0 || snakeXY[0][0] >= ScreenWidth || snakeXY[1][0] >= ScreenHeight) {
-        return 1;  // Collision detected
+// Draw what one step changed over the last frame: the same cost at any snake length
+static void Snake_DrawStep(OLED_Frame *frame, const Snake_State *state, int events) {
+    int x = Snake_SegmentX(state, state->length);
+    int y = Snake_SegmentY(state, state->length);
+
+    // The cell the tail left, unless the head moved into it
+    if (!Snake_TestCell(state, x, y)) {
+        Snake_EraseCell(frame, x, y);
     }
 
-    // Collision with itself
-    for (int i = 1; i < snakeLength; i++) {
-        if (snakeXY[0][0] == snakeXY[0][i] && snakeXY[1][0] == snakeXY[1][i]) {
-            return 1;  // Collision detected
-        }
+    // The old head becomes body, the new one is drawn over whatever was there
+    Snake_ReplaceCell(frame, Snake_SegmentX(state, 1), Snake_SegmentY(state, 1), SNAKE_SPRITE_BODY);
+    if (state->status != SNAKE_LOST) {
+        Snake_ReplaceCell(frame, Snake_SegmentX(state, 0), Snake_SegmentY(state, 0), SNAKE_SPRITE_HEAD);
+    }
+    if (state->status != SNAKE_WON) {
+        Snake_ReplaceCell(frame, Snake_FoodX(state), Snake_FoodY(state), SNAKE_SPRITE_FOOD);
     }
 
-    return 0;  // No collision
+    if (events & SNAKE_EV_ATE) {
+        Snake_RefreshInfoBar(frame, state->score, state->speed);
+    }
+    OLED_FrameEnd(frame);
 }
 
-// Load and display the snake on the OLED screen
-void Snake_Load(int fd, int snakeXY[][SNAKE_ARRAY_SIZE], int snakeLength) {
-    for (int i = 0; i < snakeLength; i++) {
-        OLED_SetCursor(fd, snakeXY[0][i], snakeXY[1][i]);
-        OLED_Display(fd, "*");  // Display snake body as '*'
+// Step the game and send the changed part of the screen in a single batched write
+int Snake_Move(OLED_Frame *frame, Snake_State *state, int input) {
+    int events = Snake_Step(state, input);
+
+    if (events || state->status == SNAKE_RUNNING) {
+        Snake_DrawStep(frame, state, events);
     }
+    return events;
 }
 
-// Update the score and speed in the info bar
-void Snake_RefreshInfoBar(int fd, int score, int speed) {
-    char str[10];
+// Load and display the snake and the food on the OLED screen, redrawing the whole frame
+void Snake_Load(OLED_Frame *frame, const Snake_State *state) {
+    Snake_InitSprites();
+    Snake_Draw(frame, state);
+}
+
+// Draw the score and speed in the info bar
+void Snake_RefreshInfoBar(OLED_Frame *frame, int score, int speed) {
+    char str[16];
 
     // Display score
-    OLED_SetCursor(fd, 0, 7);
-    sprintf(str, "score:%d", score);
-    OLED_Display(fd, str);
+    snprintf(str, sizeof(str), "score:%d", score);
+    OLED_FrameText(frame, 0, 7, str);
 
     // Display speed
-    OLED_SetCursor(fd, 70, 7);
-    sprintf(str, "speed:%d", speed);
-    OLED_Display(fd, str);
+    snprintf(str, sizeof(str), "speed:%d", speed);
+    OLED_FrameText(frame, 70, 7, str);
+}
+
+// Set up a session on an opened display and button device
+void Snake_InitGame(Snake_Game *game, int fds, int fdb) {
+    const char *path;
+
+    memset(game, 0, sizeof(*game));
+    game->fds = fds;
+    game->fdb = fdb;
+
+    path = getenv("SNAKE_RECORD");
+    if (path && Snake_RecordOpen(&game->recorder, path)) {
+        perror("Failed to open the record log");
+    }
+    path = getenv("SNAKE_REPLAY");
+    if (path && Snake_ReplayOpen(&game->replay, path)) {
+        perror("Failed to open the replay log");
+    }
+    path = getenv("SNAKE_STATS");
+    if (path) {
+        game->stats = Snake_StatsOpen(*path ? path : SNAKE_STATS_NAME);
+        if (!game->stats) {
+            perror("Failed to open the stats page");
+        }
+    }
+    if (getenv("SNAKE_AUTOPILOT")) {
+        game->autopilot = malloc(sizeof(*game->autopilot));
+        if (!game->autopilot) {
+            perror("Failed to start the autopilot");
+        }
+    }
+}
+
+// Wait until any button is pressed and return it
+int Snake_WaitForKey(Snake_Game *game) {
+    if (game->replay.file) {
+        sleep(1);  // Leave the screen up for a moment
+        return Snake_ReplayMore(&game->replay) ? ENTER : UP;
+    }
+    if (game->autopilot) {
+        sleep(1);
+        return ENTER;
+    }
+    return Button_WaitForAnyKey(game->fdb, game->buff, sizeof(game->buff));
 }
 
 // Display the game over screen
-void Snake_GameOverScreen(int fds, int fdb, char *buff, size_t size) {
-    OLED_SetCursor(fds, 25, 3);
-    OLED_Display(fds, "GAME OVER!");
-    OLED_SetCursor(fds, 10, 4);
-    OLED_Display(fds, "PRESS TO CONTINUE");
-    Button_WaitForAnyKey(fdb, buff, size);  // Wait for key press
+void Snake_GameOverScreen(Snake_Game *game) {
+    OLED_SetCursor(game->fds, 25, 3);
+    OLED_Display(game->fds, "GAME OVER!");
+    OLED_SetCursor(game->fds, 10, 4);
+    OLED_Display(game->fds, "PRESS TO CONTINUE");
+    Snake_WaitForKey(game);  // Wait for key press
 }
 
 // Display the game win screen
-void Snake_GameWin(int fds, int fdb, char *buff, size_t size) {
-    OLED_SetCursor(fds, 25, 3);
-    OLED_Display(fds, "YOU WIN!");
-    OLED_SetCursor(fds, 10, 4);
-    OLED_Display(fds, "PRESS TO CONTINUE");
-    Button_WaitForAnyKey(fdb, buff, size);  // Wait for key press
+void Snake_GameWin(Snake_Game *game) {
+    OLED_SetCursor(game->fds, 25, 3);
+    OLED_Display(game->fds, "YOU WIN!");
+    OLED_SetCursor(game->fds, 10, 4);
+    OLED_Display(game->fds, "PRESS TO CONTINUE");
+    Snake_WaitForKey(game);  // Wait for key press
+}
+
+// Arm the tick timer to fire every waitMili milliseconds; returns when the first tick is due
+static uint64_t Snake_SetTickTimer(int tfd, int waitMili) {
+    struct itimerspec its;
+
+    its.it_interval.tv_sec = waitMili / 1000;
+    its.it_interval.tv_nsec = (long)(waitMili % 1000) * 1000000L;
+    its.it_value = its.it_interval;  // First tick one period from now
+    timerfd_settime(tfd, 0, &its, NULL);
+    return Snake_StatsNow() + (uint64_t)waitMili * 1000000ULL;
+}
+
+// Let the autopilot pick the input, keeping track of the longest planning time
+static int Snake_AutopilotInput(Snake_Game *game) {
+    struct timespec start, end;
+    long ns;
+    int input;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    input = Snake_AutopilotPlan(game->autopilot, &game->state);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    ns = (end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec);
+    if (ns > game->planWorstNs) {
+        game->planWorstNs = ns;
+    }
+    return input;
 }
 
 // Start the snake game and handle gameplay
-void Snake_StartGame(int fds, int fdb, char *buff, size_t size, int snakeXY[][SNAKE_ARRAY_SIZE], int foodXY[], int ScreenWidth, int ScreenHeight, int snakeLength, int direction, int score, int speed) {
-    int gameOver = 0;
-    clock_t endWait;
-    int waitMili = CLOCKS_PER_SEC - (speed) * (CLOCKS_PER_SEC / 10);  // Set wait time based on speed
-    int tempScore = 10 * speed;
-    int oldDirection;
-    int canChangeDirection = 1;
+void Snake_StartGame(Snake_Game *game) {
+    Snake_State *state = &game->state;
+    int input = SNAKE_NONE;  // Direction requested since the last tick
+    int events;
+    struct pollfd pfds[2];
+    uint64_t expirations;
+    uint64_t due, start, period;  // Tick timing for the stats page
+    unsigned long writes;
+
+    // Ticks come from a CLOCK_MONOTONIC timer, so their length doesn't depend on CPU load
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (tfd == -1) {
+        perror("Failed to create tick timer");
+        return;
+    }
+    due = Snake_SetTickTimer(tfd, state->waitMili);
 
-    endWait = clock() + waitMili;
+    pfds[0].events = POLLIN;  // Button presses
+    pfds[1].fd = tfd;  // Game ticks
+    pfds[1].events = POLLIN;
 
     do {
-        if (canChangeDirection) {
-            oldDirection = direction;
-            direction = Button_KeysPressedToDirection(fdb, buff, size, direction);  // Get new direction from button press
+        // After a direction change, leave further presses queued until the next tick.
+        // A replay or the autopilot ignores the buttons altogether. A negative fd is
+        // skipped by poll(), which would otherwise keep reporting the end of a script.
+        pfds[0].fd = (input == SNAKE_NONE && !game->replay.file && !game->autopilot) ? game->fdb : -1;
+
+        // Sleep until a button is pressed or the next tick is due
+        if (poll(pfds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
         }
 
-        if (oldDirection != direction) {
-            canChangeDirection = 0;  // Prevent snake from moving in the opposite direction
+        if (pfds[0].revents & (POLLIN | POLLHUP)) {
+            int direction = Button_KeysPressedToDirection(game->fdb, game->buff, sizeof(game->buff), state->direction);  // Get new direction from button press
+
+            if (direction == BUTTON_EOF) {
+                break;  // The input has ended: stop the round where it is
+            }
+            if (direction != state->direction) {
+                input = direction;  // Applied on the next tick
+            }
         }
 
-        if (clock() >= endWait) {  // Move snake based on the game speed
-            Snake_Move(fds, snakeXY, snakeLength, direction);
-            canChangeDirection = 1;
-
-            if (Snake_EatFood(snakeXY, foodXY)) {  // Check if snake eats food
-                Snake_GenerateFood(fds, foodXY, ScreenWidth, ScreenHeight, snakeXY, snakeLength);  // Generate new food
-                snakeLength++;
-                score += 10;
-
-                // Increase speed based on score
-                if (score >= 10 * speed + tempScore) {
-                    speed++;
-                    tempScore = score;
-
-                    if (speed <= 9) {
-                        waitMili -= (CLOCKS_PER_SEC / 10);
-                    } else if (waitMili >= 40) {  // Maximum speed
-                        waitMili -= (CLOCKS_PER_SEC / 200);
-                    }
+        if (pfds[1].revents & POLLIN) {  // Move snake based on the game speed
+            if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;
+            }
+            start = Snake_StatsNow();
+            period = (uint64_t)state->waitMili * 1000000ULL;
+            due += (expirations - 1) * period;  // Expiry of the latest tick read
+
+            if (game->replay.file) {
+                if (Snake_ReplayEnded(&game->replay, state->ticks)) {
+                    break;  // The recorded round was cut short here
+                }
+                input = Snake_ReplayInput(&game->replay, state->ticks);
+            } else {
+                if (game->autopilot) {
+                    input = Snake_AutopilotInput(game);
                 }
+                if (input != SNAKE_NONE && game->recorder.file) {
+                    Snake_RecordInput(&game->recorder, state->ticks, input);
+                }
+            }
 
-                Snake_RefreshInfoBar(fds, score, speed);  // Update info bar
+            writes = OLED_WriteCount();
+            events = Snake_Move(&game->frame, state, input);
+            input = SNAKE_NONE;
+
+            if (game->stats) {
+                Snake_StatsTick(game->stats, state, start > due ? start - due : 0, expirations - 1,
+                                Snake_StatsNow() - start, OLED_WriteCount() - writes);
             }
 
-            endWait = clock() + waitMili;  // Reset wait time
+            due += period;
+            if (events & SNAKE_EV_SPEEDUP) {
+                due = Snake_SetTickTimer(tfd, state->waitMili);
+            }
         }
 
-        gameOver = Snake_CollisionDetection(snakeXY, ScreenWidth, ScreenHeight, snakeLength);  // Check for collisions
+    } while (state->status == SNAKE_RUNNING);
 
-        // Check if the snake has reached maximum length (win condition)
-        if (snakeLength >= SNAKE_ARRAY_SIZE - 5) {
-            gameOver = 2;  // Win condition
-            score += 1500;  // Bonus points for winning
-        }
+    close(tfd);
 
-    } while (!gameOver);
+    if (game->recorder.file) {
+        Snake_RecordEnd(&game->recorder, state);
+    }
+    if (game->replay.file && Snake_ReplayCheck(&game->replay, state)) {
+        fprintf(stderr, "Replay diverged from the log at tick %u\n", state->ticks);
+    }
+    if (game->autopilot) {
+        fprintf(stderr, "Autopilot: %u ticks, worst planning time %ld ns, shortest tick %d ms\n",
+                state->ticks, game->planWorstNs, state->waitMili);
+    }
 
     // Display the appropriate screen based on game over condition
-    if (gameOver == 1) {
-        Snake_GameOverScreen(fds, fdb, buff, size);
-    } else if (gameOver == 2) {
-        Snake_GameWin(fds, fdb, buff, size);
+    if (state->status == SNAKE_LOST) {
+        Snake_GameOverScreen(game);
+    } else if (state->status == SNAKE_WON) {
+        Snake_GameWin(game);
     }
 }
 
 // Initialize the game and start it
-void Snake_LoadGame(int fds, int fdb, char *buff, size_t size) {
-    int snakeXY[2][SNAKE_ARRAY_SIZE];  // Snake position array
-    int snakeLength = 2;  // Initial length of the snake
-    int direction = LEFT;  // Initial direction
-    int foodXY[] = {20, 5};  // Initial food position
-    int score = 0;
-    int ScreenWidth = 128;  // OLED screen width
-    int ScreenHeight = 7;   // OLED screen height
+void Snake_LoadGame(Snake_Game *game) {
     int speed = Snake_GetGameSpeed();  // Get game speed from user
+    uint32_t seed = game->seed;
+
+    // Seed the game's own generator once; the rules never touch the clock
+    if (!seed) {
+        seed = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+    }
 
-    // Initial snake position
-    snakeXY[0][0] = 20;
-    snakeXY[1][0] = 1;
+    // A replayed round starts the way it was recorded
+    if (game->replay.file) {
+        if (Snake_ReplayNextGame(&game->replay) != 1) {
+            return;  // Nothing left to play
+        }
+        seed = game->replay.seed;
+        speed = game->replay.speed;
+    }
+
+    Snake_Init(&game->state, seed, speed);
+    if (game->stats) {
+        Snake_StatsRound(game->stats, &game->state);
+    }
+    if (game->autopilot) {
+        Snake_AutopilotInit(game->autopilot);
+        game->planWorstNs = 0;
+    }
+    if (game->recorder.file) {
+        Snake_RecordGame(&game->recorder, seed, speed);
+    }
 
-    // Prepare and load the snake on the display
-    Snake_PrepareArray(snakeXY, snakeLength);
-    Snake_Load(fds, snakeXY, snakeLength);
-    Snake_GenerateFood(fds, foodXY, ScreenWidth, ScreenHeight, snakeXY, snakeLength);
-    Snake_RefreshInfoBar(fds, score, speed);  // Display the info bar
-    Snake_StartGame(fds, fdb, buff, size, snakeXY, foodXY, ScreenWidth, ScreenHeight, snakeLength, direction, score, speed);  // Start the game
+    // Load the snake, the food and the info bar on the display, cleared by the caller
+    OLED_FrameInit(&game->frame, game->fds);
+    Snake_Load(&game->frame, &game->state);
+    Snake_StartGame(game);  // Start the game
 }
 
@@ -0,0 +1,218 @@
+#include "snake_autopilot.h"
+
+#include <string.h>
+
+#define CELL(x, y)      ((y) * SNAKE_BOARD_W + (x))
+
+// Cycle distance from cell a forward to cell b
+static int Snake_CycleDist(const Snake_Autopilot *ap, int a, int b) {
+    int d = ap->cycle[b] - ap->cycle[a];
+    return d < 0 ? d + SNAKE_CELLS : d;
+}
+
+// Neighbours of a cell inside the board, returns how many
+static int Snake_Neighbours(int cell, int out[4]) {
+    int x = cell % SNAKE_BOARD_W, y = cell / SNAKE_BOARD_W, n = 0;
+
+    if (y > 0) out[n++] = cell - SNAKE_BOARD_W;
+    if (x > 0) out[n++] = cell - 1;
+    if (x < SNAKE_BOARD_W - 1) out[n++] = cell + 1;
+    if (y < SNAKE_BOARD_H - 1) out[n++] = cell + SNAKE_BOARD_W;
+    return n;
+}
+
+// Direction that moves from cell a to its neighbour b
+static int Snake_DirectionTo(int a, int b) {
+    if (b == a - SNAKE_BOARD_W) return SNAKE_UP;
+    if (b == a + SNAKE_BOARD_W) return SNAKE_DOWN;
+    if (b == a - 1) return SNAKE_LEFT;
+    return SNAKE_RIGHT;
+}
+
+static int Snake_TestBit(const uint64_t *bits, int cell) {
+    return (bits[cell / 64] >> (cell % 64)) & 1;
+}
+
+static void Snake_SetBit(uint64_t *bits, int cell) {
+    bits[cell / 64] |= 1ULL << (cell % 64);
+}
+
+static void Snake_ClearBit(uint64_t *bits, int cell) {
+    bits[cell / 64] &= ~(1ULL << (cell % 64));
+}
+
+// Build the cycle: along one even side in a serpentine, back along the first row or column
+void Snake_AutopilotInit(Snake_Autopilot *ap) {
+    int pos = 0, x, y, i;
+
+    memset(ap, 0, sizeof(*ap));
+    ap->foodCell = -1;
+
+    if (SNAKE_BOARD_W % 2 == 0 && SNAKE_BOARD_H > 1) {
+        // Row 0 left to right, then columns right to left over rows 1..H-1
+        for (x = 0; x < SNAKE_BOARD_W; x++) {
+            ap->cycleCell[pos++] = CELL(x, 0);
+        }
+        for (x = SNAKE_BOARD_W - 1; x >= 0; x--) {
+            for (i = 1; i < SNAKE_BOARD_H; i++) {
+                y = ((SNAKE_BOARD_W - 1 - x) % 2 == 0) ? i : SNAKE_BOARD_H - i;
+                ap->cycleCell[pos++] = CELL(x, y);
+            }
+        }
+        ap->hasCycle = 1;
+    } else if (SNAKE_BOARD_H % 2 == 0 && SNAKE_BOARD_W > 1) {
+        // Column 0 top to bottom, then rows bottom to top over columns 1..W-1
+        for (y = 0; y < SNAKE_BOARD_H; y++) {
+            ap->cycleCell[pos++] = CELL(0, y);
+        }
+        for (y = SNAKE_BOARD_H - 1; y >= 0; y--) {
+            for (i = 1; i < SNAKE_BOARD_W; i++) {
+                x = ((SNAKE_BOARD_H - 1 - y) % 2 == 0) ? i : SNAKE_BOARD_W - i;
+                ap->cycleCell[pos++] = CELL(x, y);
+            }
+        }
+        ap->hasCycle = 1;
+    }
+
+    for (i = 0; i < pos; i++) {
+        ap->cycle[ap->cycleCell[i]] = i;
+    }
+}
+
+// Check that after following the path the new head can still reach the new tail
+static int Snake_TailReachable(const Snake_Autopilot *ap, const Snake_State *state) {
+    uint64_t occupied[SNAKE_OCC_WORDS], seen[SNAKE_OCC_WORDS] = { 0 };
+    uint16_t queue[SNAKE_CELLS];
+    int next[4], head, tail, cell, steps = ap->pathLen;
+    int i, n, qh = 0, qt = 0;
+
+    // The snake grows by one on the food, so the first steps - 1 tail cells are freed
+    memcpy(occupied, state->occupied, sizeof(occupied));
+    for (i = 0; i < steps - 1 && i < state->length; i++) {
+        cell = Snake_SegmentCell(state, state->length - 1 - i);
+        Snake_ClearBit(occupied, cell);
+    }
+    for (i = 0; i < steps; i++) {
+        Snake_SetBit(occupied, ap->path[i]);
+    }
+    for (i = 0; i < steps - 1 - state->length; i++) {
+        Snake_ClearBit(occupied, ap->path[i]);  // Path longer than the snake: its start is freed too
+    }
+
+    // New tail: segment length-1 counted back from the food on the combined body + path
+    head = ap->path[steps - 1];
+    i = state->length - steps;  // Index of the new tail in the old body, if still there
+    if (i >= 0) {
+        tail = Snake_SegmentCell(state, i);
+    } else {
+        tail = ap->path[-i - 1];
+    }
+
+    // Flood fill from the head over free cells
+    queue[qt++] = head;
+    Snake_SetBit(seen, head);
+    while (qh < qt) {
+        n = Snake_Neighbours(queue[qh++], next);
+        for (i = 0; i < n; i++) {
+            if (next[i] == tail) {
+                return 1;
+            }
+            if (!Snake_TestBit(seen, next[i]) && !Snake_TestBit(occupied, next[i])) {
+                Snake_SetBit(seen, next[i]);
+                queue[qt++] = next[i];
+            }
+        }
+    }
+    return 0;
+}
+
+// Shortest path to the food that moves forward along the cycle and stays ahead of the tail
+static void Snake_Replan(Snake_Autopilot *ap, const Snake_State *state, int head, int food) {
+    int16_t prev[SNAKE_CELLS];
+    uint16_t queue[SNAKE_CELLS];
+    int next[4], tail, tailDist, cell, d, i, n, qh = 0, qt = 0;
+
+    ap->pathLen = 0;
+    ap->pathPos = 0;
+    ap->foodCell = food;
+    ap->plans++;
+
+    tail = Snake_SegmentCell(state, state->length - 1);
+    tailDist = Snake_CycleDist(ap, head, tail);
+    if (tailDist == 0) {
+        tailDist = SNAKE_CELLS;  // One-cell snake
+    }
+
+    memset(prev, -1, sizeof(prev));
+    prev[head] = head;
+    queue[qt++] = head;
+
+    while (qh < qt && prev[food] < 0) {
+        cell = queue[qh++];
+        d = Snake_CycleDist(ap, head, cell);
+        n = Snake_Neighbours(cell, next);
+        for (i = 0; i < n; i++) {
+            int nd = Snake_CycleDist(ap, head, next[i]);
+
+            // Forward only, and never onto or past the tail
+            if (prev[next[i]] >= 0 || nd <= d || nd >= tailDist || Snake_TestBit(state->occupied, next[i])) {
+                continue;
+            }
+            prev[next[i]] = cell;
+            queue[qt++] = next[i];
+        }
+    }
+    if (prev[food] < 0) {
+        return;  // Food is behind the tail on the cycle; follow the cycle to it
+    }
+
+    // Walk back from the food to get the path length, then fill it in forwards
+    for (cell = food; cell != head; cell = prev[cell]) {
+        ap->pathLen++;
+    }
+    for (cell = food, i = ap->pathLen - 1; cell != head; cell = prev[cell], i--) {
+        ap->path[i] = cell;
+    }
+
+    if (!Snake_TailReachable(ap, state)) {
+        ap->pathLen = 0;
+        ap->rejected++;
+    }
+}
+
+// Any neighbour the head can enter this tick, for boards without a cycle
+static int Snake_SafeNeighbour(const Snake_State *state, int head) {
+    int next[4], i, n = Snake_Neighbours(head, next);
+    int tail = Snake_SegmentCell(state, state->length - 1);
+
+    for (i = 0; i < n; i++) {
+        if (!Snake_TestBit(state->occupied, next[i]) || next[i] == tail) {
+            return next[i];
+        }
+    }
+    return next[0];  // Trapped
+}
+
+int Snake_AutopilotPlan(Snake_Autopilot *ap, const Snake_State *state) {
+    int head = Snake_SegmentCell(state, 0);
+    int food = state->food;
+    int target, dir;
+
+    if (!ap->hasCycle) {
+        target = Snake_SafeNeighbour(state, head);
+    } else {
+        // Plan once per food: after a failed attempt (pathLen 0) the cycle leads to the food
+        if (food != ap->foodCell || (ap->pathLen && ap->pathPos >= ap->pathLen)) {
+            Snake_Replan(ap, state, head, food);
+        }
+        if (ap->pathPos < ap->pathLen) {
+            target = ap->path[ap->pathPos++];
+        } else {
+            target = ap->cycleCell[(ap->cycle[head] + 1) % SNAKE_CELLS];
+            ap->cycleMoves++;
+        }
+    }
+
+    dir = Snake_DirectionTo(head, target);
+    return dir == state->direction ? SNAKE_NONE : dir;
+}
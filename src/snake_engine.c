@@ -0,0 +1,254 @@
+#include "snake_engine.h"
+
+#include <string.h>
+
+// Next number from the xorshift32 generator
+uint32_t Snake_Random(Snake_State *state) {
+    uint32_t x = state->rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state->rng = x;
+    return x;
+}
+
+// Feed one value into an FNV-1a hash
+static uint64_t Snake_HashInt(uint64_t hash, uint32_t value) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Hash the game by content, so the ring position doesn't matter
+uint64_t Snake_Hash(const Snake_State *state) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    int i;
+
+    hash = Snake_HashInt(hash, state->length);
+    for (i = 0; i < state->length; i++) {
+        hash = Snake_HashInt(hash, Snake_SegmentX(state, i));
+        hash = Snake_HashInt(hash, Snake_SegmentY(state, i));
+    }
+    hash = Snake_HashInt(hash, Snake_FoodX(state));
+    hash = Snake_HashInt(hash, Snake_FoodY(state));
+    hash = Snake_HashInt(hash, state->direction);
+    hash = Snake_HashInt(hash, state->score);
+    hash = Snake_HashInt(hash, state->speed);
+    hash = Snake_HashInt(hash, state->tempScore);
+    hash = Snake_HashInt(hash, state->waitMili);
+    hash = Snake_HashInt(hash, state->status);
+    hash = Snake_HashInt(hash, state->rng);
+    hash = Snake_HashInt(hash, state->ticks);
+    return hash;
+}
+
+// Apply a requested direction unless it reverses the current one
+int Snake_TurnDirection(int direction, int input) {
+    if (input == SNAKE_DOWN && direction != SNAKE_UP) {
+        direction = input;
+    } else if (input == SNAKE_UP && direction != SNAKE_DOWN) {
+        direction = input;
+    } else if (input == SNAKE_LEFT && direction != SNAKE_RIGHT) {
+        direction = input;
+    } else if (input == SNAKE_RIGHT && direction != SNAKE_LEFT) {
+        direction = input;
+    }
+    return direction;
+}
+
+// Mark a cell as covered
+static void Snake_SetCell(Snake_State *state, int cell) {
+    if (cell < SNAKE_CELLS) {
+        state->occupied[cell / 64] |= 1ULL << (cell % 64);
+    }
+}
+
+// Mark a cell as free
+static void Snake_ClearCell(Snake_State *state, int cell) {
+    if (cell < SNAKE_CELLS) {
+        state->occupied[cell / 64] &= ~(1ULL << (cell % 64));
+    }
+}
+
+// Count the board cells not covered by the snake
+int Snake_CountFree(const Snake_State *state) {
+    int i, used = 0;
+    for (i = 0; i < SNAKE_OCC_WORDS; i++) {
+        used += __builtin_popcountll(state->occupied[i]);
+    }
+    return SNAKE_CELLS - used;
+}
+
+// Free cells of one grid word; bits past the end of the board don't count
+static uint64_t Snake_FreeBits(const Snake_State *state, int word) {
+    int valid = SNAKE_CELLS - word * 64;
+    uint64_t mask = valid >= 64 ? ~0ULL : (1ULL << valid) - 1;
+
+    return ~state->occupied[word] & mask;
+}
+
+// Check collision with snake's body, a single bit test
+int Snake_CheckCollisionWithBody(const Snake_State *state, int x, int y) {
+    return Snake_TestCell(state, x, y);
+}
+
+// Place the food at a random cell not covered by the snake, scanning the grid words: O(words)
+void Snake_GenerateFood(Snake_State *state) {
+    int free = Snake_CountFree(state);
+    int n, word, count;
+    uint64_t bits;
+
+    if (!free) {
+        return;  // Board full, nowhere to put it
+    }
+
+    // Scale a 32-bit random number to [0, free) without a division, then find the n-th free cell
+    n = ((uint64_t)Snake_Random(state) * free) >> 32;
+    for (word = 0; word < SNAKE_OCC_WORDS; word++) {
+        bits = Snake_FreeBits(state, word);
+        count = __builtin_popcountll(bits);
+        if (n < count) {
+            break;
+        }
+        n -= count;
+    }
+    while (n--) {
+        bits &= bits - 1;  // Drop the lowest free cell
+    }
+    state->food = word * 64 + __builtin_ctzll(bits);
+}
+
+// Prepare snake's initial position in the array
+void Snake_PrepareArray(Snake_State *state) {
+    int i, x;
+    int snakeX = Snake_SegmentX(state, 0);
+    int snakeY = Snake_SegmentY(state, 0);
+
+    // Start with an empty board
+    memset(state->occupied, 0, sizeof(state->occupied));
+    Snake_SetCell(state, Snake_SegmentCell(state, 0));
+
+    for (i = 1; i <= state->length; i++) {
+        x = snakeX - i;  // Initialize snake's x-positions, keep the row
+        state->body[(state->head - i) & SNAKE_RING_MASK] = x >= 0 ? snakeY * SNAKE_BOARD_W + x : SNAKE_CELL_NONE;
+        if (i < state->length) {
+            Snake_SetCell(state, Snake_SegmentCell(state, i));
+        }
+    }
+}
+
+// Move the snake by pushing a new head; the old tail stays in the ring at segment [length]
+void Snake_MoveArray(Snake_State *state, int direction) {
+    int x = Snake_SegmentX(state, 0);
+    int y = Snake_SegmentY(state, 0);
+
+    // Update the head's position based on direction
+    switch (direction) {
+        case SNAKE_DOWN:
+            y++;
+            break;
+        case SNAKE_RIGHT:
+            x++;
+            break;
+        case SNAKE_UP:
+            y--;
+            break;
+        case SNAKE_LEFT:
+            x--;
+            break;
+    }
+
+    state->head = (state->head + 1) & SNAKE_RING_MASK;
+    state->body[state->head] = Snake_InBoard(x, y) ? y * SNAKE_BOARD_W + x : SNAKE_CELL_NONE;
+
+    // The old tail is now segment [length]; free its cell
+    Snake_ClearCell(state, Snake_SegmentCell(state, state->length));
+}
+
+// Check if the snake has eaten the food
+int Snake_EatFood(const Snake_State *state) {
+    return Snake_SegmentCell(state, 0) == state->food;
+}
+
+// Check for collisions with walls or itself
+int Snake_CollisionDetection(const Snake_State *state) {
+    int cell = Snake_SegmentCell(state, 0);
+
+    // Collision with walls
+    if (cell == SNAKE_CELL_NONE) {
+        return 1;  // Collision detected
+    }
+
+    // Collision with itself; the head isn't marked yet, so any set bit is another segment
+    return (state->occupied[cell / 64] >> (cell % 64)) & 1;
+}
+
+// Start a new game: a two-cell snake on line 1 heading left, food at a random cell
+void Snake_Init(Snake_State *state, uint32_t seed, int speed) {
+    memset(state, 0, sizeof(*state));
+    state->rng = seed ? seed : 0x9E3779B9u;  // xorshift32 never leaves 0
+    state->speed = speed;
+    state->tempScore = 10 * speed;
+    state->waitMili = 1000 - speed * 100;  // Tick period in milliseconds, based on speed
+    state->direction = SNAKE_LEFT;
+    state->length = 2;
+    state->body[state->head] = 1 * SNAKE_BOARD_W + 4;  // Column 4, line 1
+
+    Snake_PrepareArray(state);
+    Snake_GenerateFood(state);
+}
+
+// Advance the game by one tick
+int Snake_Step(Snake_State *state, int input) {
+    int events = 0;
+
+    if (state->status != SNAKE_RUNNING) {
+        return 0;
+    }
+
+    state->direction = Snake_TurnDirection(state->direction, input);
+    Snake_MoveArray(state, state->direction);
+    state->ticks++;
+
+    if (Snake_EatFood(state)) {
+        state->length++;  // Growing is just not dropping the old tail
+        Snake_SetCell(state, Snake_SegmentCell(state, state->length - 1));
+        state->score += 10;
+        events |= SNAKE_EV_ATE;
+
+        // Increase speed based on score
+        if (state->score >= 10 * state->speed + state->tempScore) {
+            state->speed++;
+            state->tempScore = state->score;
+
+            if (state->speed <= 9) {
+                state->waitMili -= 100;
+            } else if (state->waitMili >= 40) {  // Maximum speed
+                state->waitMili -= 5;
+            }
+            events |= SNAKE_EV_SPEEDUP;
+        }
+    }
+
+    if (Snake_CollisionDetection(state)) {
+        state->status = SNAKE_LOST;
+        events |= SNAKE_EV_LOST;
+        return events;
+    }
+
+    Snake_SetCell(state, Snake_SegmentCell(state, 0));
+
+    if (state->length >= SNAKE_WIN_LENGTH) {
+        state->status = SNAKE_WON;
+        state->score += 1500;  // Bonus points for winning
+        events |= SNAKE_EV_WON;
+    } else if (events & SNAKE_EV_ATE) {
+        Snake_GenerateFood(state);
+    }
+
+    return events;
+}
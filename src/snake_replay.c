@@ -0,0 +1,204 @@
+#include "snake_replay.h"
+
+#include <string.h>
+
+#define SNAKE_REPLAY_BUFFER     65536   // stdio buffer for recording
+
+// Write an unsigned LEB128 varint
+static void Snake_PutVarint(FILE *file, uint64_t value) {
+    while (value >= 0x80) {
+        putc((int)(value & 0x7f) | 0x80, file);
+        value >>= 7;
+    }
+    putc((int)value, file);
+}
+
+// Read an unsigned LEB128 varint, returns -1 at the end of the file or on overflow
+static int Snake_GetVarint(FILE *file, uint64_t *value) {
+    int c, shift = 0;
+
+    *value = 0;
+    do {
+        c = getc(file);
+        if (c == EOF || shift > 63) {
+            return -1;
+        }
+        *value |= (uint64_t)(c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+
+    return 0;
+}
+
+// Write a little-endian integer of the given size
+static void Snake_PutLE(FILE *file, uint64_t value, int bytes) {
+    while (bytes--) {
+        putc((int)(value & 0xff), file);
+        value >>= 8;
+    }
+}
+
+// Read a little-endian integer of the given size
+static int Snake_GetLE(FILE *file, uint64_t *value, int bytes) {
+    int c, i;
+
+    *value = 0;
+    for (i = 0; i < bytes; i++) {
+        c = getc(file);
+        if (c == EOF) {
+            return -1;
+        }
+        *value |= (uint64_t)c << (8 * i);
+    }
+    return 0;
+}
+
+int Snake_RecordOpen(Snake_Recorder *rec, const char *path) {
+    memset(rec, 0, sizeof(*rec));
+    rec->file = fopen(path, "ab");
+    if (!rec->file) {
+        return -1;
+    }
+    setvbuf(rec->file, NULL, _IOFBF, SNAKE_REPLAY_BUFFER);
+    return 0;
+}
+
+void Snake_RecordGame(Snake_Recorder *rec, uint32_t seed, int speed) {
+    fwrite(SNAKE_REPLAY_MAGIC, 1, 4, rec->file);
+    putc(SNAKE_REPLAY_VERSION, rec->file);
+    Snake_PutLE(rec->file, seed, 4);
+    putc(speed, rec->file);
+    rec->lastTick = 0;
+}
+
+void Snake_RecordInput(Snake_Recorder *rec, uint32_t tick, int direction) {
+    Snake_PutVarint(rec->file, 1 + ((uint64_t)(tick - rec->lastTick) << 2 | (direction - 1)));
+    rec->lastTick = tick;
+}
+
+void Snake_RecordEnd(Snake_Recorder *rec, const Snake_State *state) {
+    putc(0, rec->file);
+    Snake_PutVarint(rec->file, state->ticks);
+    Snake_PutLE(rec->file, Snake_Hash(state), 8);
+    fflush(rec->file);  // A finished game is on disk even if the program is killed later
+}
+
+void Snake_RecordClose(Snake_Recorder *rec) {
+    if (rec->file) {
+        fclose(rec->file);
+        rec->file = NULL;
+    }
+}
+
+int Snake_ReplayOpen(Snake_Replay *rp, const char *path) {
+    memset(rp, 0, sizeof(*rp));
+    rp->file = fopen(path, "rb");
+    rp->ended = 1;  // No game started yet
+    return rp->file ? 0 : -1;
+}
+
+// Read the next input or the end record of the current game
+static void Snake_ReplayRead(Snake_Replay *rp) {
+    uint64_t value, hash;
+
+    if (rp->ended || rp->hasInput) {
+        return;
+    }
+    if (Snake_GetVarint(rp->file, &value)) {
+        rp->ended = -1;  // Truncated, e.g. the recording was killed mid-game
+        return;
+    }
+
+    if (value == 0) {
+        if (Snake_GetVarint(rp->file, &value) || Snake_GetLE(rp->file, &hash, 8)) {
+            rp->ended = -1;
+            return;
+        }
+        rp->ended = 1;
+        rp->endTicks = (uint32_t)value;
+        rp->endHash = hash;
+        return;
+    }
+
+    value--;
+    rp->inputTick = rp->lastTick + (uint32_t)(value >> 2);
+    rp->inputDir = (int)(value & 3) + 1;
+    rp->lastTick = rp->inputTick;
+    rp->hasInput = 1;
+}
+
+int Snake_ReplayNextGame(Snake_Replay *rp) {
+    char magic[4];
+    uint64_t seed;
+    int version, speed;
+
+    // Skip the rest of the current game
+    while (!rp->ended) {
+        rp->hasInput = 0;
+        Snake_ReplayRead(rp);
+    }
+    if (rp->ended < 0) {
+        return -1;
+    }
+
+    if (fread(magic, 1, 4, rp->file) != 4) {
+        return 0;  // End of the log
+    }
+    version = getc(rp->file);
+    if (memcmp(magic, SNAKE_REPLAY_MAGIC, 4) || version != SNAKE_REPLAY_VERSION ||
+        Snake_GetLE(rp->file, &seed, 4) || (speed = getc(rp->file)) == EOF) {
+        rp->ended = -1;
+        return -1;
+    }
+
+    rp->seed = (uint32_t)seed;
+    rp->speed = speed;
+    rp->lastTick = 0;
+    rp->hasInput = 0;
+    rp->ended = 0;
+    return 1;
+}
+
+int Snake_ReplayMore(Snake_Replay *rp) {
+    int c;
+
+    if (rp->ended <= 0) {
+        return rp->ended == 0;  // Still inside a game, or damaged
+    }
+    c = getc(rp->file);
+    if (c == EOF) {
+        return 0;
+    }
+    ungetc(c, rp->file);
+    return 1;
+}
+
+int Snake_ReplayInput(Snake_Replay *rp, uint32_t tick) {
+    Snake_ReplayRead(rp);
+    if (rp->hasInput && rp->inputTick == tick) {
+        rp->hasInput = 0;
+        return rp->inputDir;
+    }
+    return SNAKE_NONE;
+}
+
+int Snake_ReplayEnded(Snake_Replay *rp, uint32_t tick) {
+    Snake_ReplayRead(rp);  // Past the last input, this reads the end record
+    return rp->ended == 1 && tick >= rp->endTicks;
+}
+
+int Snake_ReplayCheck(Snake_Replay *rp, const Snake_State *state) {
+    // Inputs after the game ended would mean the replay diverged
+    Snake_ReplayRead(rp);
+    if (rp->ended != 1) {
+        return -1;
+    }
+    return (state->ticks == rp->endTicks && Snake_Hash(state) == rp->endHash) ? 0 : -1;
+}
+
+void Snake_ReplayClose(Snake_Replay *rp) {
+    if (rp->file) {
+        fclose(rp->file);
+        rp->file = NULL;
+    }
+}
@@ -0,0 +1,157 @@
+#include "snake_stats.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SNAKE_STATS_RETRIES     1000    // Attempts of a reader before giving up on a stuck writer
+
+uint64_t Snake_StatsNow(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Make seq odd before changing the page; the fence keeps the changes after it
+static void Snake_StatsWriteBegin(Snake_Stats *stats) {
+    uint32_t seq = atomic_load_explicit(&stats->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&stats->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+// Make seq even again once the changes are visible
+static void Snake_StatsWriteEnd(Snake_Stats *stats) {
+    uint32_t seq = atomic_load_explicit(&stats->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&stats->seq, seq + 1, memory_order_release);
+}
+
+static void Snake_StatsAdd(Snake_Histogram *hist, uint64_t value) {
+    int bucket = value ? 64 - __builtin_clzll(value) : 0;
+
+    hist->count[bucket < SNAKE_STATS_BUCKETS ? bucket : SNAKE_STATS_BUCKETS - 1]++;
+    hist->sum += value;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+// Copy the state fields the page shows
+static void Snake_StatsState(Snake_Stats *stats, const Snake_State *state) {
+    stats->ticks = state->ticks;
+    stats->speed = state->speed;
+    stats->waitMili = state->waitMili;
+    stats->score = state->score;
+    stats->length = state->length;
+    stats->status = state->status;
+    stats->updatedNs = Snake_StatsNow();
+}
+
+Snake_Stats *Snake_StatsOpen(const char *name) {
+    Snake_Stats *stats;
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+
+    if (fd == -1) {
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(*stats)) == -1) {
+        close(fd);
+        return NULL;
+    }
+    stats = mmap(NULL, sizeof(*stats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid
+    if (stats == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Reset a page left by an earlier game; seq keeps counting so readers see the change
+    Snake_StatsWriteBegin(stats);
+    stats->magic = SNAKE_STATS_MAGIC;
+    stats->version = SNAKE_STATS_VERSION;
+    memset((char *)stats + offsetof(Snake_Stats, pid), 0, sizeof(*stats) - offsetof(Snake_Stats, pid));
+    stats->pid = getpid();
+    Snake_StatsWriteEnd(stats);
+    return stats;
+}
+
+const Snake_Stats *Snake_StatsAttach(const char *name) {
+    const Snake_Stats *stats;
+    int fd = shm_open(name, O_RDONLY, 0);
+    struct stat st;
+
+    if (fd == -1) {
+        return NULL;
+    }
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(*stats)) {
+        close(fd);
+        return NULL;
+    }
+    stats = mmap(NULL, sizeof(*stats), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return stats == MAP_FAILED ? NULL : stats;
+}
+
+void Snake_StatsRound(Snake_Stats *stats, const Snake_State *state) {
+    Snake_StatsWriteBegin(stats);
+    stats->rounds++;
+    Snake_StatsState(stats, state);
+    Snake_StatsWriteEnd(stats);
+}
+
+void Snake_StatsTick(Snake_Stats *stats, const Snake_State *state, uint64_t lateNs, uint64_t missed,
+                     uint64_t renderNs, unsigned long writes) {
+    Snake_StatsWriteBegin(stats);
+    stats->totalTicks++;
+    stats->missed += missed;
+    if (lateNs + renderNs > (uint64_t)state->waitMili * 1000000ULL) {
+        stats->overruns++;
+    }
+    Snake_StatsAdd(&stats->lateUs, lateNs / 1000);
+    Snake_StatsAdd(&stats->renderUs, renderNs / 1000);
+    Snake_StatsAdd(&stats->writes, writes);
+    Snake_StatsState(stats, state);
+    Snake_StatsWriteEnd(stats);
+}
+
+int Snake_StatsRead(const Snake_Stats *stats, Snake_Stats *copy) {
+    uint32_t seq;
+    int i;
+
+    for (i = 0; i < SNAKE_STATS_RETRIES; i++) {
+        seq = atomic_load_explicit(&stats->seq, memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();  // The game is in the middle of an update
+            continue;
+        }
+        memcpy(copy, (const void *)stats, sizeof(*copy));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&stats->seq, memory_order_relaxed) == seq) {
+            return (copy->magic == SNAKE_STATS_MAGIC && copy->version == SNAKE_STATS_VERSION) ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+uint64_t Snake_StatsPercentile(const Snake_Histogram *hist, double percent) {
+    uint64_t total = 0, seen = 0, bound;
+    int i;
+
+    for (i = 0; i < SNAKE_STATS_BUCKETS; i++) {
+        total += hist->count[i];
+    }
+    for (i = 0; i < SNAKE_STATS_BUCKETS; i++) {
+        seen += hist->count[i];
+        if (hist->count[i] && seen >= percent / 100.0 * total) {
+            bound = (i == SNAKE_STATS_BUCKETS - 1) ? hist->max : (1ULL << i) - 1;  // Inclusive upper bound
+            return bound < hist->max ? bound : hist->max;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "button_event.h"
+
+/*
+ * Presses simulated buttons and measures what reaches user space, to test
+ * button_driver without the board (see button_sim/gpio_sim_setup.sh).
+ *
+ * usage: button_sim_bench -d sim_chip_dir [-n presses] [-r presses_per_s] [-b burst] [-c consumer_delay_us]
+ *   -d  sysfs directory of the gpio-sim chip, printed by gpio_sim_setup.sh
+ *   -b  presses sent back to back, bursts are spaced to keep the average rate
+ *   -c  sleep after every read(), to model a busy game loop
+ *
+ * An injector thread presses the five lines in turn by switching their pull
+ * down and back up. The main thread reads struct btn_event records from
+ * /dev/my_button_snake and takes the IRQ-to-user-space latency of each press
+ * from its kernel timestamp. Edges that never arrive were either dropped by
+ * the driver's full queue (its "dropped" counter) or merged before the IRQ
+ * (edges faster than the line's interrupt handling). Exits with status 1 if
+ * any press was lost.
+ */
+
+#define SIM_DEV_FILE    "/dev/my_button_snake"
+#define SIM_DROPPED     "/sys/class/gpio_btn_class/my_button_snake/dropped"
+#define SIM_LINES       5       // UP, LEFT, RIGHT, DOWN, ENTER on lines 0-4
+#define SIM_READ_BATCH  16      // Events per read(), same as the driver's batch
+#define SIM_SETTLE_MS   500     // Wait for late events after the last press
+
+static struct {
+    const char *dir;
+    long presses;
+    double rate;
+    int burst;
+    long consumer_delay_us;
+    int pull_fd[SIM_LINES];
+    atomic_int done;            // Injector finished
+} sim;
+
+static int64_t Sim_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void Sim_SleepUntil(int64_t ns) {
+    struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// Read the driver's dropped counter
+static long Sim_Dropped(void) {
+    long value = -1;
+    FILE *f = fopen(SIM_DROPPED, "r");
+
+    if (f) {
+        if (fscanf(f, "%ld", &value) != 1) {
+            value = -1;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+// Set the pull of a simulated line; the buttons are active low
+static void Sim_Pull(int line, const char *pull) {
+    if (pwrite(sim.pull_fd[line], pull, strlen(pull), 0) < 0) {
+        perror("pull");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Press and release each line in turn, in bursts spaced to keep the average rate
+static void *Sim_Inject(void *arg) {
+    int64_t next = Sim_Now();
+    int64_t burst_ns = (int64_t)(sim.burst * 1e9 / sim.rate);
+    long i;
+    int line;
+
+    for (i = 0; i < sim.presses; i++) {
+        if (i % sim.burst == 0) {
+            Sim_SleepUntil(next);
+            next += burst_ns;
+        }
+        line = i % SIM_LINES;
+        Sim_Pull(line, "pull-down");  // Press
+        Sim_Pull(line, "pull-up");    // Release
+    }
+
+    atomic_store(&sim.done, 1);
+    return NULL;
+}
+
+static int Sim_CompareLatency(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double Sim_Percentile(const int64_t *sorted, long n, double p) {
+    return n ? sorted[(long)(p / 100.0 * (n - 1))] / 1000.0 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    struct btn_event evs[SIM_READ_BATCH];
+    struct pollfd pfd;
+    pthread_t injector;
+    int64_t *latency, last_event = 0;
+    long received = 0, releases = 0, dropped_before, dropped, lost, missing;
+    char path[512];
+    ssize_t r;
+    int opt, fd, i, n;
+
+    sim.presses = 1000;
+    sim.rate = 100;
+    sim.burst = 1;
+
+    while ((opt = getopt(argc, argv, "d:n:r:b:c:")) != -1) {
+        switch (opt) {
+        case 'd':
+            sim.dir = optarg;
+            break;
+        case 'n':
+            sim.presses = atol(optarg);
+            break;
+        case 'r':
+            sim.rate = atof(optarg);
+            break;
+        case 'b':
+            sim.burst = atoi(optarg);
+            break;
+        case 'c':
+            sim.consumer_delay_us = atol(optarg);
+            break;
+        default:
+            sim.dir = NULL;
+            break;
+        }
+    }
+    if (!sim.dir || sim.presses < 1 || sim.rate <= 0 || sim.burst < 1) {
+        fprintf(stderr, "usage: %s -d sim_chip_dir [-n presses] [-r presses_per_s] [-b burst] [-c consumer_delay_us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < SIM_LINES; i++) {
+        snprintf(path, sizeof(path), "%s/sim_gpio%d/pull", sim.dir, i);
+        sim.pull_fd[i] = open(path, O_WRONLY);
+        if (sim.pull_fd[i] == -1) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fd = open(SIM_DEV_FILE, O_RDONLY | O_NONBLOCK);
+    if (fd == -1) {
+        perror(SIM_DEV_FILE);
+        return EXIT_FAILURE;
+    }
+    while (read(fd, evs, sizeof(evs)) > 0) {
+        // Drop events queued before the test
+    }
+
+    latency = malloc(sim.presses * sizeof(*latency));
+    if (!latency) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+    dropped_before = Sim_Dropped();
+
+    if (pthread_create(&injector, NULL, Sim_Inject, NULL)) {
+        perror("pthread_create");
+        return EXIT_FAILURE;
+    }
+
+    // Consume until the injector is done and no event came for SIM_SETTLE_MS
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    for (;;) {
+        if (poll(&pfd, 1, 10) <= 0) {
+            if (atomic_load(&sim.done) && Sim_Now() - last_event > SIM_SETTLE_MS * 1000000LL) {
+                break;
+            }
+            continue;
+        }
+
+        r = read(fd, evs, sizeof(evs));
+        if (r <= 0) {
+            continue;
+        }
+        last_event = Sim_Now();
+
+        n = r / sizeof(evs[0]);
+        for (i = 0; i < n; i++) {
+            if (!evs[i].pressed) {
+                releases++;
+            } else if (received < sim.presses) {
+                latency[received++] = last_event - evs[i].ts_ns;
+            }
+        }
+
+        if (sim.consumer_delay_us) {
+            usleep(sim.consumer_delay_us);
+        }
+    }
+    pthread_join(injector, NULL);
+
+    dropped = Sim_Dropped();
+    dropped = (dropped >= 0 && dropped_before >= 0) ? dropped - dropped_before : 0;
+    lost = sim.presses - received;
+    missing = 2 * sim.presses - received - releases;  // Press and release edges that never arrived
+
+    qsort(latency, received, sizeof(*latency), Sim_CompareLatency);
+
+    printf("presses %ld  rate %.0f/s  burst %d  consumer delay %ld us\n",
+           sim.presses, sim.rate, sim.burst, sim.consumer_delay_us);
+    printf("received %ld presses, %ld releases\n", received, releases);
+    printf("lost %ld presses (%.3f%%); missing edges %ld: dropped by the full queue %ld, merged before the IRQ %ld\n",
+           lost, 100.0 * lost / sim.presses, missing, dropped, missing > dropped ? missing - dropped : 0);
+    printf("latency us: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           Sim_Percentile(latency, received, 50), Sim_Percentile(latency, received, 90),
+           Sim_Percentile(latency, received, 99), Sim_Percentile(latency, received, 99.9),
+           received ? latency[received - 1] / 1000.0 : 0);
+
+    free(latency);
+    close(fd);
+    return lost ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+#include <glob.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "snake.h"
+
+/*
+ * Measures the I2C traffic the SSD1306 driver generates for the game's own
+ * command sequences. Run it against the real panel or, on a machine without
+ * one, against the virtual adapter in i2c_virt/ (see README).
+ *
+ * usage: oled_i2c_bench [-s seed] [-f frames] [-r replay_log]
+ *
+ * Each operation is written to /dev/my_ssd1306_device, followed by fsync()
+ * so the driver's frame worker has sent it, and the driver's i2c_transactions
+ * and i2c_bytes counters are read before and after. Game frames come from the
+ * autopilot, or from the first game of a replay log, drawn by Snake_Move().
+ */
+
+#define BENCH_SYSFS_GLOB    "/sys/bus/i2c/drivers/ssd1306/*-003c"
+
+static const long bench_khz[] = { 100, 400, 1000 };  // Bus clocks to estimate
+#define BENCH_CLOCKS        (sizeof(bench_khz) / sizeof(bench_khz[0]))
+
+static char bench_sysfs[256];  // Driver's sysfs directory
+
+typedef struct {
+    unsigned long xfers;
+    unsigned long bytes;
+} Bench_Count;
+
+// Read one counter of the driver
+static unsigned long Bench_ReadCounter(const char *name) {
+    char path[300];
+    unsigned long value = 0;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", bench_sysfs, name);
+    f = fopen(path, "r");
+    if (!f || fscanf(f, "%lu", &value) != 1) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(f);
+    return value;
+}
+
+static Bench_Count Bench_Read(void) {
+    Bench_Count c = { Bench_ReadCounter("i2c_transactions"), Bench_ReadCounter("i2c_bytes") };
+    return c;
+}
+
+// Traffic since `before`, once everything written has reached the bus
+static Bench_Count Bench_Since(int fd, Bench_Count before) {
+    Bench_Count now;
+
+    OLED_Sync(fd);
+    now = Bench_Read();
+    now.xfers -= before.xfers;
+    now.bytes -= before.bytes;
+    return now;
+}
+
+/*
+ * Microseconds on the wire at `khz`: per transfer a start bit, the address
+ * byte with its ACK and a stop bit; 9 bit times for every byte with its ACK.
+ */
+static double Bench_BusMicros(double xfers, double bytes, long khz) {
+    return (xfers * (1 + 9 + 1) + bytes * 9) * 1000.0 / khz;
+}
+
+static void Bench_PrintHeader(void) {
+    size_t i;
+
+    printf("%-28s %8s %8s", "operation", "xfers", "bytes");
+    for (i = 0; i < BENCH_CLOCKS; i++) {
+        printf("  us@%-4ldk", bench_khz[i]);
+    }
+    printf("\n");
+}
+
+static void Bench_PrintRow(const char *name, double xfers, double bytes) {
+    size_t i;
+
+    printf("%-28s %8.1f %8.1f", name, xfers, bytes);
+    for (i = 0; i < BENCH_CLOCKS; i++) {
+        printf("  %9.0f", Bench_BusMicros(xfers, bytes, bench_khz[i]));
+    }
+    printf("\n");
+}
+
+// Run one operation from a known screen and print its traffic
+#define BENCH_OP(fd, name, op) do {                         \
+        Bench_Count before_ = Bench_Read(), d_;             \
+        op;                                                 \
+        d_ = Bench_Since(fd, before_);                      \
+        Bench_PrintRow(name, d_.xfers, d_.bytes);           \
+    } while (0)
+
+// The single operations the game issues outside of the board frames
+static void Bench_Operations(int fd) {
+    OLED_Batch batch;
+    unsigned char column[OLED_WIDTH];
+
+    memset(column, 0xAA, sizeof(column));
+
+    BENCH_OP(fd, "clear (full screen)", OLED_Clear(fd));
+    BENCH_OP(fd, "cursor", OLED_SetCursor(fd, 25, 3));
+    BENCH_OP(fd, "text \"GAME OVER!\"", OLED_Display(fd, "GAME OVER!"));
+    BENCH_OP(fd, "cursor + text, 17 chars", (OLED_SetCursor(fd, 10, 4), OLED_Display(fd, "PRESS TO CONTINUE")));
+    BENCH_OP(fd, "clear (game over screen)", OLED_Clear(fd));
+    BENCH_OP(fd, "batch: blit one page", (OLED_BatchBegin(&batch, fd),
+                                          OLED_BatchBlit(&batch, 0, 0, column, OLED_WIDTH),
+                                          OLED_BatchFlush(&batch)));
+    BENCH_OP(fd, "batch: clear one page", (OLED_BatchBegin(&batch, fd),
+                                           OLED_BatchClearPage(&batch, 0),
+                                           OLED_BatchFlush(&batch)));
+    OLED_Clear(fd);
+    OLED_Sync(fd);
+}
+
+// Play one game frame by frame and print the traffic per frame
+static void Bench_Frames(int fd, uint32_t seed, long frames, const char *log) {
+    static Snake_Autopilot autopilot;
+    static OLED_Frame frame;
+    Snake_Replay replay = { 0 };
+    Snake_State state;
+    Bench_Count before, d, total = { 0, 0 }, worst = { 0, 0 };
+    long n = 0;
+    int input;
+
+    if (log) {
+        if (Snake_ReplayOpen(&replay, log) || Snake_ReplayNextGame(&replay) != 1) {
+            fprintf(stderr, "%s: no game to replay\n", log);
+            exit(EXIT_FAILURE);
+        }
+        seed = replay.seed;
+    }
+    Snake_Init(&state, seed, log ? replay.speed : 1);
+    Snake_AutopilotInit(&autopilot);
+
+    before = Bench_Read();
+    OLED_FrameInit(&frame, fd);
+    Snake_Load(&frame, &state);
+    d = Bench_Since(fd, before);
+    Bench_PrintRow("game: first frame", d.xfers, d.bytes);
+
+    while (state.status == SNAKE_RUNNING && n < frames && !(log && Snake_ReplayEnded(&replay, state.ticks))) {
+        input = log ? Snake_ReplayInput(&replay, state.ticks) : Snake_AutopilotPlan(&autopilot, &state);
+
+        before = Bench_Read();
+        Snake_Move(&frame, &state, input);
+        d = Bench_Since(fd, before);
+
+        total.xfers += d.xfers;
+        total.bytes += d.bytes;
+        if (d.bytes > worst.bytes) {
+            worst = d;
+        }
+        n++;
+    }
+
+    if (n) {
+        Bench_PrintRow("game: frame, mean", (double)total.xfers / n, (double)total.bytes / n);
+        Bench_PrintRow("game: frame, largest", worst.xfers, worst.bytes);
+    }
+    printf("\n%ld frames, snake length %d, %s\n", n, state.length,
+           state.status == SNAKE_WON ? "won" : state.status == SNAKE_LOST ? "lost" : "still running");
+
+    if (log) {
+        Snake_ReplayClose(&replay);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t seed = 1;
+    long frames = 100000;
+    const char *log = NULL;
+    glob_t g;
+    int opt, fd;
+
+    while ((opt = getopt(argc, argv, "s:f:r:")) != -1) {
+        switch (opt) {
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            frames = atol(optarg);
+            break;
+        case 'r':
+            log = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed] [-f frames] [-r replay_log]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (glob(BENCH_SYSFS_GLOB, 0, NULL, &g) || g.gl_pathc < 1) {
+        fprintf(stderr, "No ssd1306 device under %s; load the driver first\n", BENCH_SYSFS_GLOB);
+        return EXIT_FAILURE;
+    }
+    snprintf(bench_sysfs, sizeof(bench_sysfs), "%s", g.gl_pathv[0]);
+    globfree(&g);
+
+    OLED_SetBackend("dev");
+    fd = OLED_OpenDevFile();
+
+    OLED_Clear(fd);
+    OLED_Sync(fd);
+
+    Bench_PrintHeader();
+    Bench_Operations(fd);
+    Bench_Frames(fd, seed, frames, log);
+
+    close(fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,376 @@
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_engine.h"
+#include "snake_autopilot.h"
+
+/*
+ * Plays many independent seeded games headless and reports how they went,
+ * for tuning the speed and score curves off the board.
+ *
+ * usage: snake_batch [-n games] [-t threads] [-s first_seed] [-v speed] [-m max_ticks] [-a] [-S]
+ *   -a  play with the autopilot instead of the greedy player, and time its planning
+ *   -S  also time the batch on 1, 2, 4 ... threads and print the scaling
+ *
+ * Game i uses seed first_seed + i, so a batch gives the same results on any
+ * number of threads. Each thread starts with an equal slice of the game
+ * indices and, once its slice runs out, steals half of another thread's.
+ */
+
+#define BATCH_MAX_THREADS   256
+#define BATCH_SCORE_BUCKETS 16
+
+// Result of one game
+struct batch_result {
+    int score;
+    int length;
+    int speed;           // Speed reached
+    int status;          // SNAKE_LOST, SNAKE_WON or SNAKE_RUNNING if it hit max_ticks
+    uint32_t ticks;
+    uint64_t play_ms;    // Sum of the tick periods, the time the game would take on the board
+    uint32_t plan_worst_ns;  // Longest autopilot planning time
+    uint64_t plan_ns;        // Total autopilot planning time
+};
+
+// A worker's slice of game indices, packed as next << 32 | end
+struct batch_worker {
+    _Atomic uint64_t range;
+    long games;          // Games this worker ran
+    long steals;         // Successful steals
+    pthread_t thread;
+} __attribute__((aligned(64)));
+
+static struct {
+    long games;
+    int threads;
+    uint32_t seed;
+    int speed;
+    uint32_t max_ticks;
+    int autopilot;
+    struct batch_result *results;
+    struct batch_worker workers[BATCH_MAX_THREADS];
+} batch;
+
+static double Batch_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A cell the head can move into without dying this tick
+static int Batch_Safe(const Snake_State *state, int x, int y) {
+    if (!Snake_InBoard(x, y)) {
+        return 0;
+    }
+    if (!Snake_TestCell(state, x, y)) {
+        return 1;
+    }
+    // The tail moves away this tick unless the snake eats
+    return x == Snake_SegmentX(state, state->length - 1) && y == Snake_SegmentY(state, state->length - 1) &&
+           !(x == Snake_FoodX(state) && y == Snake_FoodY(state));
+}
+
+// Greedy player: the safe move that gets closest to the food
+static int Batch_Policy(const Snake_State *state) {
+    static const int dx[5] = { 0, 0, -1, 1, 0 };
+    static const int dy[5] = { 0, -1, 0, 0, 1 };
+    int hx = Snake_SegmentX(state, 0);
+    int hy = Snake_SegmentY(state, 0);
+    int best = SNAKE_NONE, best_dist = 1 << 30;
+    int dir, x, y, dist;
+
+    for (dir = SNAKE_UP; dir <= SNAKE_DOWN; dir++) {
+        if (Snake_TurnDirection(state->direction, dir) != dir) {
+            continue;  // Reversing isn't allowed
+        }
+        x = hx + dx[dir];
+        y = hy + dy[dir];
+        if (!Batch_Safe(state, x, y)) {
+            continue;
+        }
+        dist = abs(x - Snake_FoodX(state)) + abs(y - Snake_FoodY(state));
+        if (dist < best_dist) {
+            best = dir;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+// Thread CPU time in nanoseconds, so time spent preempted by other workers doesn't count
+static uint64_t Batch_CpuNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Let the autopilot pick the input, timing it
+static int Batch_Autopilot(Snake_Autopilot *ap, const Snake_State *state, struct batch_result *result) {
+    uint64_t start = Batch_CpuNs();
+    int input = Snake_AutopilotPlan(ap, state);
+    uint32_t ns = (uint32_t)(Batch_CpuNs() - start);
+
+    result->plan_ns += ns;
+    if (ns > result->plan_worst_ns) {
+        result->plan_worst_ns = ns;
+    }
+    return input;
+}
+
+static void Batch_Play(long index) {
+    struct batch_result *result = &batch.results[index];
+    Snake_Autopilot ap;
+    Snake_State state;
+
+    Snake_Init(&state, batch.seed + (uint32_t)index, batch.speed);
+    memset(result, 0, sizeof(*result));
+    if (batch.autopilot) {
+        Snake_AutopilotInit(&ap);
+    }
+
+    while (state.status == SNAKE_RUNNING && state.ticks < batch.max_ticks) {
+        result->play_ms += state.waitMili;
+        Snake_Step(&state, batch.autopilot ? Batch_Autopilot(&ap, &state, result) : Batch_Policy(&state));
+    }
+
+    result->score = state.score;
+    result->length = state.length;
+    result->speed = state.speed;
+    result->status = state.status;
+    result->ticks = state.ticks;
+}
+
+// Take the next index from our own slice
+static long Batch_Pop(struct batch_worker *self) {
+    uint64_t range = atomic_load(&self->range);
+    uint32_t next, end;
+
+    do {
+        next = range >> 32;
+        end = (uint32_t)range;
+        if (next >= end) {
+            return -1;
+        }
+    } while (!atomic_compare_exchange_weak(&self->range, &range, (uint64_t)(next + 1) << 32 | end));
+
+    return next;
+}
+
+// Move the upper half of some other worker's slice into ours and run its first index
+static long Batch_Steal(struct batch_worker *self) {
+    int i, id = self - batch.workers;
+    struct batch_worker *victim;
+    uint64_t range;
+    uint32_t next, end, mid;
+
+    for (i = 1; i < batch.threads; i++) {
+        victim = &batch.workers[(id + i) % batch.threads];
+        range = atomic_load(&victim->range);
+
+        do {
+            next = range >> 32;
+            end = (uint32_t)range;
+            if (next >= end) {
+                break;
+            }
+            mid = next + (end - next) / 2;
+        } while (!atomic_compare_exchange_weak(&victim->range, &range, (uint64_t)next << 32 | mid));
+
+        if (next < end) {
+            atomic_store(&self->range, (uint64_t)(mid + 1) << 32 | end);
+            self->steals++;
+            return mid;
+        }
+    }
+    return -1;  // Everything is taken
+}
+
+static void *Batch_Worker(void *arg) {
+    struct batch_worker *self = arg;
+    long index;
+
+    for (;;) {
+        index = Batch_Pop(self);
+        if (index < 0) {
+            index = Batch_Steal(self);
+        }
+        if (index < 0) {
+            break;
+        }
+        Batch_Play(index);
+        self->games++;
+    }
+    return NULL;
+}
+
+// Run the whole batch on the given number of threads and return the wall time
+static double Batch_Run(int threads) {
+    double start;
+    long per;
+    int i;
+
+    batch.threads = threads;
+    per = (batch.games + threads - 1) / threads;
+    for (i = 0; i < threads; i++) {
+        long first = i * per < batch.games ? i * per : batch.games;
+        long last = first + per < batch.games ? first + per : batch.games;
+
+        atomic_init(&batch.workers[i].range, (uint64_t)first << 32 | (uint64_t)last);
+        batch.workers[i].games = 0;
+        batch.workers[i].steals = 0;
+    }
+
+    start = Batch_Now();
+    for (i = 0; i < threads; i++) {
+        if (pthread_create(&batch.workers[i].thread, NULL, Batch_Worker, &batch.workers[i])) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(batch.workers[i].thread, NULL);
+    }
+    return Batch_Now() - start;
+}
+
+static int Batch_CompareInt(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+static void Batch_Report(double seconds) {
+    int *scores = malloc(batch.games * sizeof(*scores));
+    long speeds[32] = { 0 };
+    long buckets[BATCH_SCORE_BUCKETS] = { 0 };
+    long won = 0, timeouts = 0, i;
+    double score_sum = 0, ticks_sum = 0, play_sum = 0, plan_sum = 0;
+    uint32_t plan_worst = 0;
+    int bucket_width;
+
+    if (!scores) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < batch.games; i++) {
+        const struct batch_result *r = &batch.results[i];
+
+        scores[i] = r->score;
+        score_sum += r->score;
+        ticks_sum += r->ticks;
+        play_sum += r->play_ms;
+        won += r->status == SNAKE_WON;
+        timeouts += r->status == SNAKE_RUNNING;
+        speeds[r->speed < 31 ? r->speed : 31]++;
+        plan_sum += r->plan_ns;
+        if (r->plan_worst_ns > plan_worst) {
+            plan_worst = r->plan_worst_ns;
+        }
+    }
+    qsort(scores, batch.games, sizeof(*scores), Batch_CompareInt);
+
+    printf("games %ld  threads %d  seconds %.3f  games/s %.0f  ticks/s %.0f\n",
+           batch.games, batch.threads, seconds, batch.games / seconds, ticks_sum / seconds);
+    printf("won %ld  lost %ld  timed out %ld\n", won, batch.games - won - timeouts, timeouts);
+    printf("score mean %.1f  p10 %d  p50 %d  p90 %d  p99 %d  max %d\n",
+           score_sum / batch.games, scores[batch.games / 10], scores[batch.games / 2],
+           scores[batch.games * 9 / 10], scores[batch.games * 99 / 100], scores[batch.games - 1]);
+    printf("ticks mean %.1f  play time mean %.1f s\n", ticks_sum / batch.games, play_sum / batch.games / 1000);
+    if (batch.autopilot) {
+        printf("autopilot planning mean %.0f ns  worst %u ns\n", plan_sum / ticks_sum, plan_worst);
+    }
+
+    // Score histogram
+    bucket_width = scores[batch.games - 1] / BATCH_SCORE_BUCKETS + 1;
+    for (i = 0; i < batch.games; i++) {
+        buckets[scores[i] / bucket_width]++;
+    }
+    printf("score histogram:\n");
+    for (i = 0; i < BATCH_SCORE_BUCKETS; i++) {
+        if (buckets[i]) {
+            printf("  %6ld-%-6ld %8ld\n", i * bucket_width, (i + 1) * bucket_width - 1, buckets[i]);
+        }
+    }
+
+    printf("final speed:\n");
+    for (i = 0; i < 32; i++) {
+        if (speeds[i]) {
+            printf("  %2ld%s %8ld\n", i, i == 31 ? "+" : " ", speeds[i]);
+        }
+    }
+
+    printf("thread    games   steals\n");
+    for (i = 0; i < batch.threads; i++) {
+        printf("  %4ld %8ld %8ld\n", i, batch.workers[i].games, batch.workers[i].steals);
+    }
+    free(scores);
+}
+
+int main(int argc, char *argv[]) {
+    int scaling = 0, opt, t;
+    double seconds, base = 0;
+
+    batch.games = 100000;
+    batch.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (batch.threads > BATCH_MAX_THREADS) {
+        batch.threads = BATCH_MAX_THREADS;
+    }
+    batch.seed = 1;
+    batch.speed = 1;
+    batch.max_ticks = 100000;
+
+    while ((opt = getopt(argc, argv, "n:t:s:v:m:aS")) != -1) {
+        switch (opt) {
+        case 'n': batch.games = atol(optarg); break;
+        case 't': batch.threads = atoi(optarg); break;
+        case 's': batch.seed = strtoul(optarg, NULL, 0); break;
+        case 'v': batch.speed = atoi(optarg); break;
+        case 'm': batch.max_ticks = strtoul(optarg, NULL, 0); break;
+        case 'a': batch.autopilot = 1; break;
+        case 'S': scaling = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n games] [-t threads] [-s first_seed] [-v speed] [-m max_ticks] [-a] [-S]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (batch.games < 1 || batch.games > UINT32_MAX || batch.threads < 1 || batch.threads > BATCH_MAX_THREADS) {
+        fprintf(stderr, "games must be 1-%u and threads 1-%d\n", UINT32_MAX, BATCH_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    batch.results = calloc(batch.games, sizeof(*batch.results));
+    if (!batch.results) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    if (scaling) {
+        int threads = batch.threads;
+
+        printf("threads   games/s  speedup\n");
+        for (t = 1;; t = t * 2 < threads ? t * 2 : threads) {
+            seconds = Batch_Run(t);
+            if (t == 1) {
+                base = seconds;
+            }
+            printf("  %4d %9.0f %8.2f\n", t, batch.games / seconds, base / seconds);
+            if (t == threads) {
+                break;
+            }
+        }
+        batch.threads = threads;
+    }
+
+    seconds = Batch_Run(batch.threads);
+    Batch_Report(seconds);
+
+    free(batch.results);
+    return 0;
+}
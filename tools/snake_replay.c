@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "snake_engine.h"
+#include "snake_replay.h"
+
+/*
+ * Re-runs replay logs through the game engine at full CPU speed and checks
+ * every game against the hash recorded when it ended.
+ *
+ * usage: snake_replay log...
+ *
+ * Exits with status 1 if any game diverged or a log is damaged, so a corpus
+ * of logs works as a regression test for rule changes.
+ */
+
+static double Replay_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Play every game of one log, returns the number of games that failed
+static long Replay_File(const char *path, long *games, uint64_t *ticks) {
+    Snake_Replay replay;
+    Snake_State state;
+    long failed = 0;
+    int ret;
+
+    if (Snake_ReplayOpen(&replay, path)) {
+        perror(path);
+        return 1;
+    }
+
+    while ((ret = Snake_ReplayNextGame(&replay)) == 1) {
+        Snake_Init(&state, replay.seed, replay.speed);
+
+        // Stop at the recorded end even if the game would go on, so a diverged replay can't loop forever
+        while (state.status == SNAKE_RUNNING && !Snake_ReplayEnded(&replay, state.ticks)) {
+            Snake_Step(&state, Snake_ReplayInput(&replay, state.ticks));
+        }
+
+        if (Snake_ReplayCheck(&replay, &state)) {
+            printf("%s: game %ld (seed %u) diverged at tick %u\n", path, *games, replay.seed, state.ticks);
+            failed++;
+        }
+        (*games)++;
+        *ticks += state.ticks;
+    }
+
+    if (ret < 0) {
+        printf("%s: damaged after %ld games\n", path, *games);
+        failed++;
+    }
+    Snake_ReplayClose(&replay);
+    return failed;
+}
+
+int main(int argc, char *argv[]) {
+    long games = 0, failed = 0;
+    uint64_t ticks = 0;
+    double start, seconds;
+    int i;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s log...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    start = Replay_Now();
+    for (i = 1; i < argc; i++) {
+        failed += Replay_File(argv[i], &games, &ticks);
+    }
+    seconds = Replay_Now() - start;
+
+    printf("games %ld  failed %ld  ticks %llu  seconds %.3f  ticks/s %.0f\n",
+           games, failed, (unsigned long long)ticks, seconds, seconds > 0 ? ticks / seconds : 0);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
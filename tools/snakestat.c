@@ -0,0 +1,150 @@
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "snake_stats.h"
+
+/*
+ * Watches the game loop of a running game through its stats page (see
+ * inc/snake_stats.h). Start the game with SNAKE_STATS set, e.g.
+ * SNAKE_STATS=/snake_stats, then run snakestat on the same board.
+ *
+ * usage: snakestat [-n name] [-i interval_ms] [-c count] [-H]
+ *   -n  shared memory object, default /snake_stats
+ *   -i  time between lines, default 1000 ms
+ *   -c  exit after this many lines
+ *   -H  print the full histograms instead of one line per interval
+ *
+ * Each line shows the current round and, over the whole session, the tick
+ * lateness and render time percentiles (bucket bounds, microseconds), the
+ * mean device writes per frame, the timer expirations the loop missed and
+ * the ticks that overran their period. The game keeps up at a speed as long
+ * as missed and overruns stay at 0.
+ */
+
+static double Stat_Mean(const Snake_Histogram *hist) {
+    uint64_t n = 0;
+    int i;
+
+    for (i = 0; i < SNAKE_STATS_BUCKETS; i++) {
+        n += hist->count[i];
+    }
+    return n ? (double)hist->sum / n : 0;
+}
+
+static void Stat_PrintHeader(void) {
+    printf("%6s %5s %7s %5s %6s %5s | %23s | %23s | %6s %7s %8s\n",
+           "round", "speed", "tick_ms", "score", "length", "tps",
+           "late_us p50/p99/max", "render_us p50/p99/max", "writes", "missed", "overruns");
+}
+
+static void Stat_PrintLine(const Snake_Stats *s, double tps) {
+    char late[32], render[32];
+
+    snprintf(late, sizeof(late), "%llu/%llu/%llu",
+             (unsigned long long)Snake_StatsPercentile(&s->lateUs, 50),
+             (unsigned long long)Snake_StatsPercentile(&s->lateUs, 99), (unsigned long long)s->lateUs.max);
+    snprintf(render, sizeof(render), "%llu/%llu/%llu",
+             (unsigned long long)Snake_StatsPercentile(&s->renderUs, 50),
+             (unsigned long long)Snake_StatsPercentile(&s->renderUs, 99), (unsigned long long)s->renderUs.max);
+    printf("%6u %5u %7u %5u %6u %5.1f | %23s | %23s | %6.2f %7llu %8llu\n",
+           s->rounds, s->speed, s->waitMili, s->score, s->length, tps, late, render,
+           Stat_Mean(&s->writes), (unsigned long long)s->missed, (unsigned long long)s->overruns);
+}
+
+static void Stat_PrintHistogram(const char *name, const Snake_Histogram *hist) {
+    int i;
+
+    printf("%s (mean %.1f, max %llu)\n", name, Stat_Mean(hist), (unsigned long long)hist->max);
+    printf("%10s %10s %10s\n", "from", "to", "count");
+    for (i = 0; i < SNAKE_STATS_BUCKETS; i++) {
+        if (!hist->count[i]) {
+            continue;
+        }
+        if (i == SNAKE_STATS_BUCKETS - 1) {
+            printf("%10llu %10s %10llu\n", i ? 1ULL << (i - 1) : 0ULL, "-", (unsigned long long)hist->count[i]);
+        } else {
+            printf("%10llu %10llu %10llu\n", i ? 1ULL << (i - 1) : 0ULL, (1ULL << i) - 1,
+                   (unsigned long long)hist->count[i]);
+        }
+    }
+}
+
+static void Stat_PrintFull(const Snake_Stats *s) {
+    printf("pid %u, %u rounds, %llu ticks, %llu missed expirations, %llu overruns\n",
+           s->pid, s->rounds, (unsigned long long)s->totalTicks,
+           (unsigned long long)s->missed, (unsigned long long)s->overruns);
+    Stat_PrintHistogram("tick lateness, us", &s->lateUs);
+    Stat_PrintHistogram("render time, us", &s->renderUs);
+    Stat_PrintHistogram("device writes per frame", &s->writes);
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = SNAKE_STATS_NAME;
+    const Snake_Stats *stats;
+    Snake_Stats now;
+    uint64_t lastTicks = 0, lastNs = 0;
+    long interval = 1000, count = -1, lines = 0;
+    int opt, full = 0;
+    double tps;
+
+    while ((opt = getopt(argc, argv, "n:i:c:H")) != -1) {
+        switch (opt) {
+        case 'n':
+            name = optarg;
+            break;
+        case 'i':
+            interval = atol(optarg);
+            break;
+        case 'c':
+            count = atol(optarg);
+            break;
+        case 'H':
+            full = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n name] [-i interval_ms] [-c count] [-H]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    stats = Snake_StatsAttach(name);
+    if (!stats) {
+        fprintf(stderr, "No stats page %s; start the game with SNAKE_STATS=%s\n", name, name);
+        return EXIT_FAILURE;
+    }
+    if (Snake_StatsRead(stats, &now)) {
+        fprintf(stderr, "%s is not a stats page of this version\n", name);
+        return EXIT_FAILURE;
+    }
+
+    if (full) {
+        Stat_PrintFull(&now);
+        return EXIT_SUCCESS;
+    }
+
+    Stat_PrintHeader();
+    while (count < 0 || lines < count) {
+        if (Snake_StatsRead(stats, &now)) {
+            fprintf(stderr, "%s: no consistent copy\n", name);
+            return EXIT_FAILURE;
+        }
+        if (kill(now.pid, 0) == -1 && errno == ESRCH) {
+            printf("game %u has exited\n", now.pid);
+            break;
+        }
+
+        // Ticks per second since the previous line
+        tps = (lastNs && now.updatedNs > lastNs) ? (now.totalTicks - lastTicks) * 1e9 / (now.updatedNs - lastNs) : 0;
+        lastTicks = now.totalTicks;
+        lastNs = now.updatedNs;
+
+        Stat_PrintLine(&now, tps);
+        fflush(stdout);
+        lines++;
+        usleep(interval * 1000);
+    }
+    return EXIT_SUCCESS;
+}